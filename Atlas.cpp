@@ -0,0 +1,192 @@
+#include "Atlas.hpp"
+
+#include "load_save_png.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+//name of the white block (not a valid sprite name, so it can't collide):
+static std::string const white_name = "";
+
+static uint32_t next_pow2(uint32_t x) {
+	uint32_t p = 1;
+	while (p < x) p *= 2;
+	return p;
+}
+
+Atlas::Atlas(uint32_t padding_) : padding(padding_) {
+}
+
+Atlas::~Atlas() {
+	if (texture) {
+		gl_state.deleted_texture(texture);
+		glDeleteTextures(1, &texture);
+	}
+	texture = 0;
+}
+
+Atlas::Image &Atlas::add_image(std::string const &name, glm::uvec2 const &size) {
+	if (texture) throw std::runtime_error("Can't add '" + name + "' to an atlas that is already built.");
+	if (name == white_name) throw std::runtime_error("Atlas sprites need a name.");
+	if (size.x == 0 || size.y == 0) throw std::runtime_error("Atlas image '" + name + "' is empty.");
+	for (auto const &image : images) {
+		if (image.name == name) throw std::runtime_error("Atlas already has an image named '" + name + "'.");
+	}
+	images.emplace_back();
+	images.back().name = name;
+	images.back().size = size;
+	return images.back();
+}
+
+void Atlas::add(std::string const &name, glm::uvec2 const &size, std::vector< glm::u8vec4 > &&pixels) {
+	if (pixels.size() != size_t(size.x) * size.y) {
+		throw std::runtime_error("Atlas image '" + name + "' has the wrong number of pixels.");
+	}
+	Image &image = add_image(name, size);
+	image.pixels = std::move(pixels);
+	image.data = image.pixels.data();
+}
+
+void Atlas::add_png(std::string const &name, std::string const &filename, TextureCache *cache) {
+	if (cache) {
+		//(the atlas builds its own mip levels, so the cache only needs the image itself)
+		TextureCache::Image loaded = cache->load(filename, false);
+		Image &image = add_image(name, loaded.size);
+		//keep whichever storage the cache's pixels are in, rather than copying them:
+		image.data = loaded.levels[0];
+		image.pixels = std::move(loaded.decoded);
+		image.mapped = std::move(loaded.mapped);
+	} else {
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > pixels;
+		load_png(filename, &size, &pixels, LowerLeftOrigin);
+		add(name, size, std::move(pixels));
+	}
+}
+
+glm::uvec2 Atlas::pack(std::vector< glm::uvec2 > const &sizes, uint32_t max_size, std::vector< glm::uvec2 > *positions_) {
+	auto &positions = *positions_;
+	positions.assign(sizes.size(), glm::uvec2(0));
+	if (sizes.empty()) return glm::uvec2(1);
+
+	//tallest first, so each shelf wastes little height:
+	std::vector< uint32_t > order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](uint32_t a, uint32_t b) {
+		if (sizes[a].y != sizes[b].y) return sizes[a].y > sizes[b].y;
+		return sizes[a].x > sizes[b].x;
+	});
+
+	//shelf-pack into a given width, returning the height used:
+	auto shelves = [&](uint32_t width, std::vector< glm::uvec2 > *placed) {
+		uint32_t x = 0, y = 0, shelf = 0;
+		for (uint32_t i : order) {
+			if (x + sizes[i].x > width) {
+				y += shelf;
+				x = 0;
+				shelf = 0;
+			}
+			if (placed) (*placed)[i] = glm::uvec2(x, y);
+			x += sizes[i].x;
+			shelf = std::max(shelf, sizes[i].y);
+		}
+		return y + shelf;
+	};
+
+	uint32_t widest = 0;
+	for (auto const &s : sizes) widest = std::max(widest, s.x);
+
+	//try each power-of-two width, keeping the smallest (then squarest) atlas that fits:
+	glm::uvec2 best = glm::uvec2(0);
+	for (uint32_t width = next_pow2(widest); width <= max_size; width *= 2) {
+		uint32_t height = next_pow2(shelves(width, nullptr));
+		if (height > max_size) continue;
+		uint64_t area = uint64_t(width) * height;
+		uint64_t best_area = uint64_t(best.x) * best.y;
+		if (best.x == 0 || area < best_area || (area == best_area && std::max(width, height) < std::max(best.x, best.y))) {
+			best = glm::uvec2(width, height);
+		}
+	}
+	if (best.x == 0) {
+		throw std::runtime_error("Atlas images don't fit in a " + std::to_string(max_size) + "x" + std::to_string(max_size) + " texture.");
+	}
+	shelves(best.x, &positions);
+	return best;
+}
+
+void Atlas::build() {
+	if (texture) throw std::runtime_error("Atlas is already built.");
+
+	//a small block of white, for solid shapes:
+	images.emplace_back();
+	images.back().name = white_name;
+	images.back().size = glm::uvec2(4, 4);
+	images.back().pixels.assign(4 * 4, glm::u8vec4(0xff));
+	images.back().data = images.back().pixels.data();
+
+	//----- pack -----
+	std::vector< glm::uvec2 > sizes;
+	sizes.reserve(images.size());
+	for (auto const &image : images) {
+		sizes.emplace_back(image.size + glm::uvec2(2 * padding));
+	}
+
+	GLint max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	std::vector< glm::uvec2 > positions;
+	size = pack(sizes, uint32_t(std::max(max_size, 64)), &positions);
+
+	//----- compose -----
+	std::vector< glm::u8vec4 > pixels(size_t(size.x) * size.y, glm::u8vec4(0));
+	glm::vec2 texel = 1.0f / glm::vec2(size);
+	for (uint32_t i = 0; i < images.size(); ++i) {
+		Image const &image = images[i];
+		glm::uvec2 at = positions[i];
+		//copy the image, extending its edge texels out through the padding:
+		for (uint32_t y = 0; y < sizes[i].y; ++y) {
+			uint32_t sy = uint32_t(std::min< int32_t >(std::max< int32_t >(int32_t(y) - int32_t(padding), 0), int32_t(image.size.y) - 1));
+			glm::u8vec4 *dst = &pixels[size_t(at.y + y) * size.x + at.x];
+			glm::u8vec4 const *src = image.data + size_t(sy) * image.size.x;
+			for (uint32_t x = 0; x < sizes[i].x; ++x) {
+				uint32_t sx = uint32_t(std::min< int32_t >(std::max< int32_t >(int32_t(x) - int32_t(padding), 0), int32_t(image.size.x) - 1));
+				dst[x] = src[sx];
+			}
+		}
+
+		glm::vec2 min = glm::vec2(at + glm::uvec2(padding));
+		glm::vec2 max = min + glm::vec2(image.size);
+		if (image.name == white_name) {
+			white_uv = 0.5f * (min + max) * texel;
+		} else {
+			Sprite &sprite = sprites[image.name];
+			sprite.uv_min = min * texel;
+			sprite.uv_max = max * texel;
+			sprite.size = image.size;
+		}
+	}
+	images.clear();
+
+	//----- upload -----
+	glGenTextures(1, &texture);
+	gl_state.bind_texture(0, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	//mipmaps are generated once, here:
+	glGenerateMipmap(GL_TEXTURE_2D);
+	gl_state.bind_texture(0, 0);
+
+	GL_ERRORS();
+}
+
+Atlas::Sprite const &Atlas::lookup(std::string const &name) const {
+	auto f = sprites.find(name);
+	if (f == sprites.end()) throw std::runtime_error("Atlas has no sprite named '" + name + "'.");
+	return f->second;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "GL.hpp"
+#include "TextureCache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Atlas packs many images into one mipmapped texture, so that sprites (and,
+ *  via a pure white texel, solid shapes) can all be drawn with a single
+ *  texture bind -- in one DrawList, with one draw call.
+ *
+ * Usage:
+ *   atlas.add_png("knife", "knife.png"); //...and so on, then:
+ *   atlas.build(); //packs, uploads, and generates mipmaps (once)
+ *   draw_list.solid_uv = atlas.white_uv;
+ *   Atlas::Sprite const &knife = atlas.lookup("knife");
+ *   draw_list.textured_rectangle(at, radius, knife.uv_min, knife.uv_max, color);
+ *   DrawListRenderer::shared->draw(draw_list, object_to_clip, atlas.texture);
+ *
+ * Images are packed onto shelves (tallest first), each surrounded by
+ *  'padding' texels copied from its edges, so filtering and the first few
+ *  mip levels don't bleed in neighboring images.
+ */
+
+//NOTE: throws on error
+struct Atlas {
+	Atlas(uint32_t padding = 4);
+	~Atlas();
+
+	Atlas(Atlas const &) = delete;
+	Atlas &operator=(Atlas const &) = delete;
+
+	//----- before build() -----
+
+	//add an image (lower-left origin, as load_png with LowerLeftOrigin gives):
+	void add(std::string const &name, glm::uvec2 const &size, std::vector< glm::u8vec4 > &&pixels);
+	//load and add a PNG (through 'cache', if given, so it isn't decoded every launch):
+	void add_png(std::string const &name, std::string const &filename, TextureCache *cache = nullptr);
+
+	//pack everything added, upload it as 'texture', and generate mipmaps:
+	void build();
+
+	//----- after build() -----
+
+	struct Sprite {
+		glm::vec2 uv_min = glm::vec2(0.0f); //texture coordinates of the lower-left corner...
+		glm::vec2 uv_max = glm::vec2(0.0f); //...and upper-right corner
+		glm::uvec2 size = glm::uvec2(0); //in pixels
+	};
+	Sprite const &lookup(std::string const &name) const;
+
+	GLuint texture = 0;
+	glm::uvec2 size = glm::uvec2(0);
+	//center of a block of pure white texels (use as DrawList::solid_uv):
+	glm::vec2 white_uv = glm::vec2(0.0f);
+
+	uint32_t padding;
+
+	std::unordered_map< std::string, Sprite > sprites;
+
+	//----- packing (no OpenGL) -----
+
+	//place rectangles of the given sizes (padding included) on shelves in an atlas at most 'max_size' on a side;
+	// returns the (power-of-two) atlas size and sets 'positions' to each rectangle's lower-left corner:
+	static glm::uvec2 pack(std::vector< glm::uvec2 > const &sizes, uint32_t max_size, std::vector< glm::uvec2 > *positions);
+
+private:
+	struct Image {
+		std::string name;
+		glm::uvec2 size;
+		glm::u8vec4 const *data = nullptr; //points into 'pixels' or 'mapped'
+		std::vector< glm::u8vec4 > pixels;
+		std::unique_ptr< MappedFile > mapped; //(texture cache entries are read straight from the mapping)
+	};
+	std::vector< Image > images; //waiting for build()
+
+	//check 'name' and start a new entry in 'images':
+	Image &add_image(std::string const &name, glm::uvec2 const &size);
+};
@@ -1,5 +1,15 @@
 #include "BobMode.hpp"
 
+//for GLProgramBatch (head_program may compile along with other programs):
+#include "gl_compile_program.hpp"
+
+//for the shared, per-frame vertex buffer and the draw list renderer that uses it:
+#include "VertexStream.hpp"
+#include "DrawListRenderer.hpp"
+
+//for skipping redundant state changes:
+#include "GLState.hpp"
+
 //for the GL_ERRORS() macro:
 #include "gl_errors.hpp"
 
@@ -7,119 +17,183 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <random>
+#include <cmath>
+
+//useful drawing constants:
+static const float wall_radius = 0.05f;
+static const float padding = 0.14f; //padding between outside of walls and edge of window
+static const glm::vec2 life_radius = glm::vec2(0.1f, 0.1f);
+
+//some nice colors from the course web page:
+#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+static const glm::u8vec4 playing_bg_color = HEX_TO_U8VEC4(0x171714ff);
+static const glm::u8vec4 lost_bg_color = HEX_TO_U8VEC4(0xaa3333ff);
+static const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xffffaaff);
+static const glm::u8vec4 heart_color = HEX_TO_U8VEC4(0xff7777ff);
+static const glm::u8vec4 hair_color = HEX_TO_U8VEC4(0x604d29ff);
+static const glm::u8vec4 dead_color = HEX_TO_U8VEC4(0x777777ff);
+//heads go from red (unhappy) to green (happy):
+static const glm::u8vec4 head_colors[HeadProgram::SkinColors] = {
+	HEX_TO_U8VEC4(0xff7777ff), HEX_TO_U8VEC4(0xeb7d34cff), HEX_TO_U8VEC4(0xebb434ff),
+	HEX_TO_U8VEC4(0xf5e536ff), HEX_TO_U8VEC4(0xcff03eff), HEX_TO_U8VEC4(0x92f041ff)
+};
+#undef HEX_TO_U8VEC4
+
+//builds the head mesh (centered on the origin) that HeadProgram draws once per head:
+// (this is what draw() used to emit for every head, every frame)
+static std::vector< BobMode::HeadVertex > make_head_mesh(glm::vec2 const &head_radius) {
+	typedef HeadProgram::Kind Kind;
+	std::vector< BobMode::HeadVertex > mesh;
+
+	auto draw_triangle = [&mesh](glm::vec3 const &a, glm::vec3 const &b, glm::vec3 const &c, glm::u8vec4 const &color, Kind kind) {
+		mesh.emplace_back(a, color, kind);
+		mesh.emplace_back(b, color, kind);
+		mesh.emplace_back(c, color, kind);
+	};
+	auto draw_circle = [&](glm::vec2 const &center, float radius, float angle_elapsed, glm::u8vec4 const &color, Kind kind) {
+		float step = angle_elapsed / DrawList::circle_segments;
+		for (uint32_t i = 0; i < DrawList::circle_segments; ++i) {
+			draw_triangle(
+				glm::vec3(center, 0.0f),
+				glm::vec3(center.x + radius * std::cos(i * step), center.y + radius * std::sin(i * step), 0.0f),
+				glm::vec3(center.x + radius * std::cos((i+1) * step), center.y + radius * std::sin((i+1) * step), 0.0f),
+				color, kind
+			);
+		}
+	};
+	//rectangle, rotated by 'angle' around its center, with optional happiness-dependent y offsets for its bottom and top:
+	auto draw_rectangle = [&](glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::u8vec4 const &color, Kind kind, float bottom_z = 0.0f, float top_z = 0.0f) {
+		glm::vec2 x = radius.x * glm::vec2(std::cos(angle), std::sin(angle));
+		glm::vec2 y = radius.y * glm::vec2(-std::sin(angle), std::cos(angle));
+		glm::vec3 p1 = glm::vec3(center - x - y, bottom_z);
+		glm::vec3 p2 = glm::vec3(center + x - y, bottom_z);
+		glm::vec3 p3 = glm::vec3(center + x + y, top_z);
+		glm::vec3 p4 = glm::vec3(center - x + y, top_z);
+		draw_triangle(p1, p2, p3, color, kind);
+		draw_triangle(p1, p3, p4, color, kind);
+	};
 
-BobMode::BobMode() {
-	//create initial heads
-    heads.emplace_back(glm::vec2(-2.5f, 0.0f), default_hair_length); 
-    heads.emplace_back(glm::vec2(0.0f, 0.0f), default_hair_length); 
-    heads.emplace_back(glm::vec2(2.5f, 0.0f), default_hair_length); 
-    heads.emplace_back(glm::vec2(5.0f, 0.0f), default_hair_length); 
-	heads.at(1).velocity = glm::vec2(0.0f, max_head_speed); 
-    heads.at(1).visible = true; 
-	heads.at(3).velocity = glm::vec2(0.0f, -max_head_speed); 
-    heads.at(3).visible = true; 
-
-	num_visible = 1; 
-
-	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	glm::vec2 eye_radius = glm::vec2(0.1f, 0.1f);
+	glm::vec2 nose_radius = glm::vec2(0.05f, 0.05f);
+	glm::vec2 nose_position = glm::vec2(0.00f, -0.05f);
+	glm::vec2 x_radius = glm::vec2(0.2f, 0.05f);
+	glm::vec2 left_eye_position = glm::vec2(-.2f, .1f);
+	glm::vec2 right_eye_position = glm::vec2(.2f, .1f);
+	glm::vec2 mouth_position = glm::vec2(0.0f, -.25f);
+	glm::vec2 left_ear_position = glm::vec2(-.5f, 0.0f);
+	glm::vec2 right_ear_position = glm::vec2(.5f, 0.0f);
+
+	//hair (bottom corners are placed by the shader from the instance's hair length and cut angle):
+	{
+		glm::u8vec4 const &c = hair_color;
+		mesh.emplace_back(glm::vec3(-head_radius.x, 0.0f, 0.0f), c, HeadProgram::Fixed);
+		mesh.emplace_back(glm::vec3( head_radius.x, 0.0f, 0.0f), c, HeadProgram::Fixed);
+		mesh.emplace_back(glm::vec3( head_radius.x, 0.0f, 0.0f), c, HeadProgram::HairRight);
+
+		mesh.emplace_back(glm::vec3(-head_radius.x, 0.0f, 0.0f), c, HeadProgram::Fixed);
+		mesh.emplace_back(glm::vec3( head_radius.x, 0.0f, 0.0f), c, HeadProgram::HairRight);
+		mesh.emplace_back(glm::vec3(-head_radius.x, 0.0f, 0.0f), c, HeadProgram::HairLeft);
 	}
 
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
+	//round part of hair:
+	draw_circle(glm::vec2(0.0f), 0.8f, 3.14f, hair_color, HeadProgram::Fixed);
+
+	//head and ears (colored per instance):
+	glm::u8vec4 skin = glm::u8vec4(0xff);
+	draw_circle(glm::vec2(0.0f), 0.65f, 2.0f * 3.142f, skin, HeadProgram::Skin);
+	draw_circle(left_ear_position, 0.25f, 2.0f * 3.142f, skin, HeadProgram::Skin);
+	draw_circle(right_ear_position, 0.25f, 2.0f * 3.142f, skin, HeadProgram::Skin);
+
+	//live eyes, or dead X-ed out eyes:
+	draw_rectangle(left_eye_position, eye_radius, 0.0f, hair_color, HeadProgram::Alive);
+	draw_rectangle(right_eye_position, eye_radius, 0.0f, hair_color, HeadProgram::Alive);
+	draw_rectangle(left_eye_position, x_radius, .79f, hair_color, HeadProgram::Dead);
+	draw_rectangle(right_eye_position, x_radius, .79f, hair_color, HeadProgram::Dead);
+	draw_rectangle(left_eye_position, x_radius, -.79f, hair_color, HeadProgram::Dead);
+	draw_rectangle(right_eye_position, x_radius, -.79f, hair_color, HeadProgram::Dead);
+
+	draw_rectangle(nose_position, nose_radius, 0.0f, hair_color, HeadProgram::Fixed);
+
+	//mouth, with corners that turn up or down with happiness
+	// (a corner is centered at +0.05 * happiness with a radius of 0.1 * happiness, so it spans -0.05 to +0.15 times happiness):
+	draw_rectangle(mouth_position, glm::vec2(0.4f, 0.05f), 0.0f, hair_color, HeadProgram::Alive);
+	draw_rectangle(mouth_position + glm::vec2( 0.4f, 0.0f), glm::vec2(0.05f, 0.0f), 0.0f, hair_color, HeadProgram::Alive, -0.05f, 0.15f);
+	draw_rectangle(mouth_position + glm::vec2(-0.4f, 0.0f), glm::vec2(0.05f, 0.0f), 0.0f, hair_color, HeadProgram::Alive, -0.05f, 0.15f);
+	draw_rectangle(mouth_position, glm::vec2(0.45f, 0.1f), 0.0f, hair_color, HeadProgram::Dead);
+
+	return mesh;
+}
 
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+BobMode::BobMode(uint32_t seed, GLProgramBatch *programs) : sim(seed), head_program(programs) {
 
-		//set up the vertex array object to describe arrays of BobMode::Vertex:
-		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
-			2, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+	//----- allocate OpenGL resources -----
+	{ //head mesh:
+		std::vector< HeadVertex > mesh = make_head_mesh(sim.head_radius);
+		head_mesh_count = GLsizei(mesh.size());
 
-		//done referring to vertex_buffer, so unbind it:
+		glGenBuffers(1, &head_mesh_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, head_mesh_buffer);
+		glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(mesh[0]), mesh.data(), GL_STATIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
-
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
 
-	{ //solid white texture:
-		//ask OpenGL to fill white_tex with the name of an unused texture object:
-		glGenTextures(1, &white_tex);
-
-		//bind that texture object as a GL_TEXTURE_2D-type texture:
-		glBindTexture(GL_TEXTURE_2D, white_tex);
-
-		//upload a 1x1 image of solid white to the texture:
-		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+	//the rest needs head_program's locations, so waits for it to link:
+	GLProgramBatch now; //(finishes right here, if not given a batch)
+	(programs ? programs : &now)->then([this]() {
+		{ //vertex array mapping the head mesh (per-vertex) and instances (per-instance) for head_program:
+			glGenVertexArrays(1, &head_vertex_array);
+			gl_state.bind_vertex_array(head_vertex_array);
+
+			glBindBuffer(GL_ARRAY_BUFFER, head_mesh_buffer);
+			glVertexAttribPointer(head_program.Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(HeadVertex), (GLbyte *)0 + 0);
+			glEnableVertexAttribArray(head_program.Position_vec4);
+			glVertexAttribPointer(head_program.Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HeadVertex), (GLbyte *)0 + 4*3);
+			glEnableVertexAttribArray(head_program.Color_vec4);
+			//(integer attribute, so glVertexAttrib*I*Pointer)
+			glVertexAttribIPointer(head_program.Kind_uint, 1, GL_UNSIGNED_BYTE, sizeof(HeadVertex), (GLbyte *)0 + 4*3 + 4*1);
+			glEnableVertexAttribArray(head_program.Kind_uint);
+
+			//instance attributes advance once per instance rather than once per vertex;
+			// they are pointed at the current frame's instances in draw():
+			for (GLuint attrib : { head_program.Center_vec2, head_program.Hair_vec2, head_program.Happiness_float, head_program.Look_uvec2 }) {
+				glVertexAttribDivisor(attrib, 1);
+				glEnableVertexAttribArray(attrib);
+			}
 
-		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			gl_state.bind_vertex_array(0);
 
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
+			GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+		}
 
-		//Okay, texture uploaded, can unbind it:
-		glBindTexture(GL_TEXTURE_2D, 0);
+		{ //head_program uniforms that never change:
+			gl_state.use_program(head_program.program);
+			glUniform2f(head_program.HEAD_RADIUS_vec2, sim.head_radius.x, sim.head_radius.y);
+			glm::vec4 skin_colors[HeadProgram::SkinColors];
+			for (uint32_t i = 0; i < HeadProgram::SkinColors; ++i) {
+				skin_colors[i] = glm::vec4(head_colors[i]) / 255.0f;
+			}
+			glUniform4fv(head_program.SKIN_COLORS_vec4_array, HeadProgram::SkinColors, glm::value_ptr(skin_colors[0]));
+			glm::vec4 dead = glm::vec4(dead_color) / 255.0f;
+			glUniform4fv(head_program.DEAD_COLOR_vec4, 1, glm::value_ptr(dead));
 
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
+			GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+		}
+	});
+	now.finish();
 }
 
 BobMode::~BobMode() {
 
 	//----- free OpenGL resources -----
-	glDeleteBuffers(1, &vertex_buffer);
-	vertex_buffer = 0;
-
-	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
-	vertex_buffer_for_color_texture_program = 0;
+	glDeleteBuffers(1, &head_mesh_buffer);
+	head_mesh_buffer = 0;
 
-	glDeleteTextures(1, &white_tex);
-	white_tex = 0;
+	gl_state.deleted_vertex_array(head_vertex_array);
+	glDeleteVertexArrays(1, &head_vertex_array);
+	head_vertex_array = 0;
 }
 
 bool BobMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
@@ -130,288 +204,32 @@ bool BobMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 			(evt.motion.x + 0.5f) / window_size.x * 2.0f - 1.0f,
 			(evt.motion.y + 0.5f) / window_size.y *-2.0f + 1.0f
 		);
-        glm::vec2 court_mouse = clip_to_court  * glm::vec3(clip_mouse, 1.0f);
-        if(!knife_thrown) knife_angle = atan2(court_mouse.y - knife.y, court_mouse.x - knife.x); 
-        else new_knife_angle = atan2(court_mouse.y - knife.y, court_mouse.x - knife.x); 
+		court_to_clip(window_size.x / float(window_size.y), &clip_to_court);
+		glm::vec2 court_mouse = clip_to_court * glm::vec3(clip_mouse, 1.0f);
+		sim.aim(court_mouse);
 	}
 	if (evt.type == SDL_MOUSEBUTTONDOWN) {
-        knife_thrown = true; 
+		sim.press_trigger();
+	}
+	if (evt.type == SDL_MOUSEBUTTONUP) {
+		sim.release_trigger();
+	}
+	if (evt.type == SDL_KEYDOWN && evt.key.repeat == 0) {
+		//number keys pick the fire mode:
+		if (evt.key.keysym.sym == SDLK_1) sim.set_fire_mode(BobSim::FireMode::Single);
+		else if (evt.key.keysym.sym == SDLK_2) sim.set_fire_mode(BobSim::FireMode::Rapid);
+		else if (evt.key.keysym.sym == SDLK_3) sim.set_fire_mode(BobSim::FireMode::Spread);
 	}
 
 	return false;
 }
 
 void BobMode::update(float elapsed) {
-    
-    //update knife position 
-    if(knife_thrown) {
-        knife = knife + knife_speed * glm::vec2(cos(knife_angle), sin(knife_angle)); 
-        //reset knife if it goes offscreen
-        if(knife.x + knife_radius.x < - court_radius.x 
-        || knife.y + knife_radius.y < - court_radius.y
-        || knife.x - knife_radius.x > court_radius.x
-        || knife.y - knife_radius.y > court_radius.y){
-            knife_thrown = false; 
-            knife_angle = new_knife_angle; 
-            knife = knife_start; 
-        }
-    }
-
-    if(lives == 0) return; 
-    //spawn new heads 
-	if(add_heads > 0 && num_visible < num_heads) {
-		add_elapsed += elapsed; 
-		if(add_elapsed > reappear_time) {
-			int randIndex = int(std::rand() * 1.0f / RAND_MAX * (num_heads - num_visible));
-
-			for (std::vector<Head>::iterator  head = std::begin(heads); head != std::end(heads); ++head) {
-				if(!head->visible) {
-					if(randIndex == 0) {
-						head->visible = true; 
-						num_visible++; 
-						add_heads--; 
-						add_elapsed = 0.0f; 
-						head->velocity.y = max_head_speed; 
-						if(std::rand() / RAND_MAX < 0.5) head->velocity.y *= -1; 
-						head->hair_length = default_hair_length; 
-						head->happiness = -1; 
-						head->dead = false; 
-						head->hair_angle = 0; 
-						head->position.y = court_radius.y - std::rand() * 1.0f / RAND_MAX * court_radius.y * 2; 
-					} 
-					randIndex--;
-				}
-			}
-
-		}
-	}
-
-    //update head position 
-    for (std::vector<Head>::iterator  head = std::begin(heads); head != std::end(heads); ++head) {
-    //for(int i = 0; i < heads.length; i++) {
-        //Head head = heads[i]; 
-        if(!head->visible) continue; 
-
-        //head disappearance after killed 
-        if(head->dead) {
-            head->vis_elapsed += elapsed; 
-            if(head->vis_elapsed >  disappear_time) {
-				head->visible = false; 
-				num_visible--; 
-			}
-            continue; 
-        }
-        if(head->happiness > happy_threshold) {
-            head->vis_elapsed += elapsed; 
-            if(head->vis_elapsed >  disappear_time) {
-				head->visible = false; 
-				num_visible--; 
-			}
-            continue; 
-        }
-        head->position += elapsed * head->velocity; 
-        //bounce off top and bottom 
-        if(head->position.y - head_radius.y < - court_radius.y){
-            head->velocity.y = abs(head->velocity.y); 
-        }
-        if(head->position.y + head_radius.x > court_radius.y) {
-            head->velocity.y = abs(head->velocity.y) * -1; 
-        }
-
-        head->cut_elapsed += elapsed; 
-        //check for collision with knife  point horizontally
-        if(head->cut_elapsed > cut_time 
-        &&knife.x + knife_radius.x * cos(knife_angle) > head->position.x - head_radius.x
-        && knife.x + knife_radius.x * cos(knife_angle) < head->position.x + head_radius.x) {
-			//if it is below the top of the head
-            if(knife.y + knife_radius.x * sin(knife_angle) < head->position.y + head_radius.y) {
-                //if it hits the head
-                if(knife.y + knife_radius.x * sin(knife_angle) > head->position.y - head_radius.y) {
-                    head->dead = true; 
-                    head->vis_elapsed = 0.0f; 
-                    head->happiness = -1;
-                    lives -= 1; 
-					add_heads++; 
-                }
-                //if it hits the hair 
-                else if(knife.y + knife_radius.x * sin(knife_angle) > head->position.y - head_radius.y - head->hair_length) {
-                    float old_length = head->hair_length; 
-                    head->hair_length = std::max(0.01f, head->position.y - head_radius.y - (knife.y + .5f * knife_radius.x * sin(knife_angle))); 
-                    head->hair_angle = knife_angle; 
-                    head->happiness = 1.0f - head->hair_length / default_hair_length * 2.0f; 
-
-                    head->cut_elapsed = 0.0f; 
-					if(head->velocity.y > 0){
-						head->velocity.y = min_head_speed + (max_head_speed - min_head_speed) * (1.0f - head->happiness) / 2.0f;
-					} 
-                    //score += old_length - head->hair_length; 
-                    if (head->happiness > happy_threshold) {
-                        head->vis_elapsed = 0.0f; 
-                        score++; 
-						max_head_speed = std::max(2.0f + score / 5.0f, 6.0f); 
-						add_heads ++; 
-                    }
-                }
-            }
-        }
-    }
+	sim.update(elapsed);
 }
 
-void BobMode::draw(glm::uvec2 const &drawable_size) {
-	//some nice colors from the course web page:
-	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
-    glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x171714ff);
-    if(lives == 0) bg_color = HEX_TO_U8VEC4(0xaa3333ff);
-	const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xffffaaff);
-	const glm::u8vec4 heart_color = HEX_TO_U8VEC4(0xff7777ff);
-	const glm::u8vec4 hair_color = HEX_TO_U8VEC4(0x604d29ff);
-	const glm::u8vec4 dead_color = HEX_TO_U8VEC4(0x777777ff);
-    const std::vector< glm::u8vec4 > head_colors = {
-		HEX_TO_U8VEC4(0xff7777ff), HEX_TO_U8VEC4(0xeb7d34cff), HEX_TO_U8VEC4(0xebb434ff),
-		HEX_TO_U8VEC4(0xf5e536ff), HEX_TO_U8VEC4(0xcff03eff), HEX_TO_U8VEC4(0x92f041ff)
-	};
-	#undef HEX_TO_U8VEC4
-
-	//other useful drawing constants:
-	const float wall_radius = 0.05f;
-	const float padding = 0.14f; //padding between outside of walls and edge of window
-
-	//---- compute vertices to draw ----
-
-	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices;
-
-	//inline helper function for rectangle drawing:
-	auto draw_rectangle = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-	};
-
-    //adapted from https://gist.github.com/linusthe3rd/803118
-    auto draw_circle = [&vertices](glm::vec2 const &center, float radius, float start_angle, float angle_elapsed, glm::u8vec4 const &color){
-        int num_points = 20; //# of triangles used to draw full circle
-        
-        float angle = angle_elapsed/ num_points;
-        
-        for(int i = 0; i < num_points;i++) { 
-            vertices.emplace_back(glm::vec3(center.x, center.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-            vertices.emplace_back(glm::vec3(center.x + (radius * cos(start_angle + i *  angle)), center.y + (radius * sin(start_angle + i * angle)), 0.0f), color, glm::vec2(0.5f, 0.5f));
-            vertices.emplace_back(glm::vec3(center.x + (radius * cos(start_angle + (i+1) *  angle)), center.y + (radius * sin(start_angle + (i+1) * angle)), 0.0f), color, glm::vec2(0.5f, 0.5f));
-        }
-    };
-
-	//inline helper function for quad drawing:
-	auto draw_quad = [&vertices](glm::vec2 const &p1, glm::vec2 const &p2, glm::vec2 const &p3, glm::vec2 const &p4, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(p1.x, p1.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(p2.x, p2.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(p3.x, p3.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(p1.x, p1.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(p3.x, p3.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(p4.x, p4.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-	};
-
-	//inline helper function for rectangle drawing with rotation:
-	auto draw_rectangle_rot = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::u8vec4 const &color) {
-        //transformation matrix, explanation at https://open.gl/transformations
-        glm::mat4 trans = glm::mat4(1.0f);
-        trans = glm::translate(trans, glm::vec3(center.x, center.y, 0.0f)); 
-        trans = glm::rotate(trans, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-        trans = glm::translate(trans, glm::vec3(-center.x, -center.y, 0.0f));
-
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x-radius.x, center.y-radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x+radius.x, center.y-radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x+radius.x, center.y+radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x-radius.x, center.y-radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x+radius.x, center.y+radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(trans * glm::vec4(center.x-radius.x, center.y+radius.y, 0.0f, 1.0f)), color, glm::vec2(0.5f, 0.5f));
-	};
-
-    //heads
-    glm::vec2 eye_radius = glm::vec2(0.1f, 0.1f); 
-    glm::vec2 nose_radius = glm::vec2(0.05f, 0.05f); 
-    glm::vec2 nose_position = glm::vec2(0.00f, -0.05f); 
-    glm::vec2 x_radius = glm::vec2(0.2f, 0.05f); 
-    glm::vec2 left_eye_position = glm::vec2(-.2f, .1f); 
-    glm::vec2 right_eye_position = glm::vec2(.2f, .1f); 
-    glm::vec2 mouth_position = glm::vec2(0.0f, -.25f); 
-    glm::vec2 left_ear_position = glm::vec2(-.5f, 0.0f); 
-    glm::vec2 right_ear_position = glm::vec2(.5f, 0.0f); 
-
-    for (std::vector<Head>::iterator  head = std::begin(heads); head != std::end(heads); ++head) {
-            if(!head->visible) continue; 
-        	//hair points 
-            glm::vec2 p1 = glm::vec2(head->position.x - head_radius.x, head->position.y ); 
-            glm::vec2 p2 = glm::vec2(head->position.x + head_radius.x, head->position.y ); 
-            glm::vec2 p3 = glm::vec2(head->position.x + head_radius.x, head->position.y - head_radius.y - head->hair_length + head_radius.x * sin(head->hair_angle)); 
-            glm::vec2 p4 = glm::vec2(head->position.x - head_radius.x, head->position.y - head_radius.y - head->hair_length);
-
-            draw_quad(p1, p2, p3, p4, hair_color);
-
-            //round part of hair 
-            draw_circle(head->position, 0.8f, 0.0f, 3.14f, hair_color);
-
-            //draw head
-        	if(head->dead || lives==0) {
-                draw_circle(head->position, 0.65f, 0.0f, 2.0f * 3.142f, dead_color);
-                draw_circle(head->position + left_ear_position, 0.25f, 0.0f, 2.0f * 3.142f, dead_color);
-                draw_circle(head->position + right_ear_position, 0.25f, 0.0f, 2.0f * 3.142f,dead_color);
-
-                //draw face
-                draw_rectangle_rot(head->position + left_eye_position, x_radius, .79f, hair_color); 
-                draw_rectangle_rot(head->position + right_eye_position, x_radius, .79f,hair_color); 
-                draw_rectangle_rot(head->position + left_eye_position, x_radius, -.79f, hair_color); 
-                draw_rectangle_rot(head->position + right_eye_position, x_radius, -.79f,hair_color); 
-                draw_rectangle(head->position + nose_position, nose_radius, hair_color); 
-                draw_rectangle(head->position + mouth_position, glm::vec2(0.45f, 0.1f), hair_color);                
-            }
-            else {
-                //draw_rectangle(head->position, head_radius, head_colors[int(head_colors.size() * .5 * (head->happiness + 1))]);
-                int color_index = int(head_colors.size() * .5f * (head->happiness + 1.0f)); 
-                draw_circle(head->position, 0.65f, 0.0f, 2.0f * 3.142f, head_colors[color_index]);
-                draw_circle(head->position + left_ear_position, 0.25f, 0.0f, 2.0f * 3.142f, head_colors[color_index]);
-                draw_circle(head->position + right_ear_position, 0.25f, 0.0f, 2.0f * 3.142f, head_colors[color_index]);
-
-
-                //draw face
-                draw_rectangle(head->position + left_eye_position, eye_radius, hair_color); 
-                draw_rectangle(head->position + right_eye_position, eye_radius, hair_color); 
-                draw_rectangle(head->position + nose_position, nose_radius, hair_color); 
-                draw_rectangle(head->position + mouth_position, glm::vec2(0.4f, 0.05f), hair_color); 
-                draw_rectangle(head->position + mouth_position + glm::vec2(0.4f, head->happiness * 0.05f), glm::vec2(0.05f, head->happiness * 0.1f), hair_color); 
-                draw_rectangle(head->position + mouth_position + glm::vec2(-0.4f, head->happiness * 0.05f), glm::vec2(0.05f, head->happiness * 0.1f), hair_color); 
-            }
-    }
-
-
-    //knife
-	draw_rectangle_rot(knife, knife_radius, knife_angle, fg_color);
-
-	//scores:
-	glm::vec2 life_radius = glm::vec2(0.1f, 0.1f);
-	for (uint32_t i = 0; i < lives; ++i) {
-		draw_rectangle(glm::vec2( court_radius.x - (2.0f + 3.0f * i) * life_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * life_radius.y), life_radius, heart_color);
-	}
-    for (uint32_t i = 0; i < score; ++i) {
-		draw_rectangle(glm::vec2( - court_radius.x + (2.0f + 3.0f * i) * life_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * life_radius.y), life_radius, head_colors[5]);
-	}
-
-	//walls:
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-
-	//------ compute court-to-window transform ------
+glm::mat4 BobMode::court_to_clip(float aspect, glm::mat3x2 *clip_to_court) const {
+	glm::vec2 const &court_radius = sim.court_radius;
 
 	//compute area that should be visible:
 	glm::vec2 scene_min = glm::vec2(
@@ -423,8 +241,6 @@ void BobMode::draw(glm::uvec2 const &drawable_size) {
 		court_radius.y + 2.0f * wall_radius + 3.0f * life_radius.y + padding
 	);
 
-	//compute window aspect ratio:
-	float aspect = drawable_size.x / float(drawable_size.y);
 	//we'll scale the x coordinate by 1.0 / aspect to make sure things stay square.
 
 	//compute scale factor for court given that...
@@ -446,54 +262,118 @@ void BobMode::draw(glm::uvec2 const &drawable_size) {
 	// so each line above is specifying a *column* of the matrix(!)
 
 	//also build the matrix that takes clip coordinates to court coordinates (used for mouse handling):
-	clip_to_court = glm::mat3x2(
+	if (clip_to_court) *clip_to_court = glm::mat3x2(
 		glm::vec2(aspect / scale, 0.0f),
 		glm::vec2(0.0f, 1.0f / scale),
 		glm::vec2(center.x, center.y)
 	);
 
-	//---- actual drawing ----
+	return court_to_clip;
+}
 
-	//clear the color buffer:
-	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+void BobMode::draw(glm::uvec2 const &drawable_size, float alpha) {
+	glm::u8vec4 bg_color = (sim.lives == 0 ? lost_bg_color : playing_bg_color);
 
-	//use alpha blending:
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	//don't use the depth test:
-	glDisable(GL_DEPTH_TEST);
+	//---- compute vertices to draw ----
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//shapes are accumulated into draw_list (which keeps its storage from frame to frame) and then uploaded+drawn at the end of this function:
+	draw_list.clear();
+
+	//heads are drawn with instancing (below), so just note what each one looks like:
+	head_instances.clear();
+	BobSim::Heads const &heads = sim.heads;
+	for (size_t h = 0; h < heads.size(); ++h) {
+		if (!heads.visible(h)) continue;
+		HeadInstance instance;
+		//interpolate between the last two simulation steps:
+		instance.Center = glm::mix(heads.prev_position(h), heads.position(h), alpha);
+		instance.Hair = glm::vec2(heads.hair_length[h], heads.hair_angle[h]);
+		instance.Happiness = heads.happiness[h];
+		instance.ColorIndex = uint8_t(std::min(int(HeadProgram::SkinColors * .5f * (heads.happiness[h] + 1.0f)), int(HeadProgram::SkinColors) - 1));
+		instance.Dead = uint8_t(heads.dead(h) || sim.lives == 0);
+		head_instances.emplace_back(instance);
+	}
 
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
+	//falling hair (batched into the same vertex list as everything else):
+	ProjectilePool const &hairs = sim.hairs;
+	float strand_radius = sim.head_radius.x / float(sim.strands_per_cut);
+	draw_list.reserve(4 * hairs.size()); //(one quad per strand)
+	for (size_t s = 0; s < hairs.size(); ++s) {
+		glm::vec2 center = glm::mix(hairs.prev_position(s), hairs.position(s), alpha);
+		float angle = glm::mix(hairs.prev_angle[s], hairs.angle[s], alpha);
+		glm::vec2 along = 0.5f * hairs.length[s] * glm::vec2(-std::sin(angle), std::cos(angle));
+		glm::vec2 across = strand_radius * glm::vec2(std::cos(angle), std::sin(angle));
+		draw_list.quad(center - along - across, center - along + across, center + along + across, center + along - across, hair_color);
+	}
+
+	//knives in flight:
+	ProjectilePool const &knives = sim.knives;
+	for (size_t k = 0; k < knives.size(); ++k) {
+		draw_list.rectangle(glm::mix(knives.prev_position(k), knives.position(k), alpha), sim.knife_radius, knives.angle[k], fg_color);
+	}
+	//knife in hand:
+	if (sim.knife_ready()) {
+		draw_list.rectangle(sim.knife_start, sim.knife_radius, sim.knife_angle, fg_color);
+	}
+
+	//scores:
+	for (uint32_t i = 0; i < sim.lives; ++i) {
+		draw_list.rectangle(glm::vec2( sim.court_radius.x - (2.0f + 3.0f * i) * life_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * life_radius.y), life_radius, heart_color);
+	}
+	for (uint32_t i = 0; i < sim.score; ++i) {
+		draw_list.rectangle(glm::vec2( - sim.court_radius.x + (2.0f + 3.0f * i) * life_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * life_radius.y), life_radius, head_colors[5]);
+	}
+
+	//walls:
+	draw_list.rectangle(glm::vec2(-sim.court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_list.rectangle(glm::vec2( sim.court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_list.rectangle(glm::vec2( 0.0f,-sim.court_radius.y-wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
+	draw_list.rectangle(glm::vec2( 0.0f, sim.court_radius.y+wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
+
+	//------ compute court-to-window transform ------
 
-	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
+	//compute window aspect ratio:
+	float aspect = drawable_size.x / float(drawable_size.y);
+	glm::mat4 court_to_clip = this->court_to_clip(aspect);
 
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
+	//---- actual drawing ----
 
+	//clear the color buffer:
+	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
 
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	//use alpha blending:
+	gl_state.enable(GL_BLEND);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	//don't use the depth test:
+	gl_state.disable(GL_DEPTH_TEST);
+
+	//----- heads -----
+	//(drawn first, since everything else goes on top of them)
+	if (!head_instances.empty()) {
+		//upload this frame's instances and point the instance attributes at them:
+		GLintptr at = VertexStream::shared->upload(head_instances.data(), head_instances.size() * sizeof(HeadInstance), sizeof(HeadInstance));
+
+		gl_state.bind_vertex_array(head_vertex_array);
+		glBindBuffer(GL_ARRAY_BUFFER, VertexStream::shared->buffer);
+		glVertexAttribPointer(head_program.Center_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(HeadInstance), (GLbyte *)0 + at + 0);
+		glVertexAttribPointer(head_program.Hair_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(HeadInstance), (GLbyte *)0 + at + 4*2);
+		glVertexAttribPointer(head_program.Happiness_float, 1, GL_FLOAT, GL_FALSE, sizeof(HeadInstance), (GLbyte *)0 + at + 4*2 + 4*2);
+		glVertexAttribIPointer(head_program.Look_uvec2, 2, GL_UNSIGNED_BYTE, sizeof(HeadInstance), (GLbyte *)0 + at + 4*2 + 4*2 + 4*1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+		gl_state.use_program(head_program.program);
+		glUniformMatrix4fv(head_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
 
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+		//one draw for every head:
+		glDrawArraysInstanced(GL_TRIANGLES, 0, head_mesh_count, GLsizei(head_instances.size()));
+	}
 
-	//reset vertex array to none:
-	glBindVertexArray(0);
+	//----- everything else -----
 
-	//reset current program to none:
-	glUseProgram(0);
+	//upload the draw list to this frame's part of the shared vertex stream, and run the OpenGL pipeline
+	// (the renderer picks the untextured program, since nothing in the list is textured):
+	DrawListRenderer::shared->draw(draw_list, court_to_clip);
 	
 
 	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
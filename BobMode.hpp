@@ -1,4 +1,6 @@
-#include "ColorTextureProgram.hpp"
+#include "BobSim.hpp"
+#include "HeadProgram.hpp"
+#include "DrawList.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
@@ -9,111 +11,71 @@
 #include <deque>
 
 /*
- * BobMode is a game mode that implements a single-player game of Pong.
+ * BobMode is a game mode that lets a player play a BobSim.
  */
 
 struct BobMode : Mode {
-	BobMode();
+	//(head_program compiles as part of 'programs', if given; don't draw until it is finished)
+	BobMode(uint32_t seed = 0, GLProgramBatch *programs = nullptr);
 	virtual ~BobMode();
 
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
-	virtual void draw(glm::uvec2 const &drawable_size) override;
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) override;
 
 	//----- game state -----
 
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-
-    glm::vec2 knife_start = glm::vec2(-6.5f, 0.0f);
-    glm::vec2 knife = glm::vec2(-6.5f, 0.0f);
-	glm::vec2 knife_radius = glm::vec2(1.0f, .05f);
-    float knife_angle = 0.0f; 
-    float new_knife_angle = 0.0f; 
-    bool knife_thrown = false; 
-    float knife_speed = 1.0f; 
-
-	uint32_t lives = 3;
-	uint32_t score = 0;
-    //float score = 0.0f; 
-
-    float default_hair_length = 2.0f; 
-    float disappear_time = 1.0f; 
-    float reappear_time = 1.5f; 
-    float happy_threshold = 0.66f; 
-    float cut_time = 0.4f; 
-
-    int num_visible = 0;
-    int num_heads = 4;
-    int add_heads = 0; 
-    float add_elapsed = 0.0f; 
-
-    glm::vec2 head_radius = glm::vec2(0.8f, 0.8f);
-    float min_head_speed = .5f; 
-    float max_head_speed = 2.0f; 
-
-    struct Head {
-        glm::vec2 position; 
-        glm::vec2 velocity; 
-        bool dead; 
-        bool visible; 
-        float hair_angle; 
-        float hair_length; 
-        //ranges from -1 to 1
-        float happiness; 
-        float vis_elapsed; 
-        float cut_elapsed; 
-        Head(glm::vec2 const &pos, float const &len) : 
-            position(pos), hair_length(len)
-        { 
-            dead = false; 
-            visible = false; 
-            hair_angle = 0; 
-            happiness = -1; 
-            velocity = glm::vec2(0.0f, 0.0f); 
-        }
-    };
-	std::vector<Head> heads;
-
-    struct Hair {
-        glm::vec2 position; 
-        glm::vec2 velocity; 
-        float length; 
-        float top_angle;
-        float bottom_angle; 
-        Hair(glm::vec2 const &pos, glm::vec2 const &vel, float const &len, float const &top, float const &bot) : 
-            position(pos), velocity(vel), length(len), top_angle(top), bottom_angle(bot) {}
-    };
-	std::vector<Hair> hairs;
-
+	//all of the gameplay lives in the (OpenGL-free) simulation:
+	BobSim sim;
 
 	//----- opengl assets / helpers ------
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
+	//shapes are collected each frame into a list of vertices:
+	DrawList draw_list;
+	//(vertex data is uploaded each frame to VertexStream::shared and drawn by DrawListRenderer::shared)
+
+	//heads are drawn as instances of one mesh, built once:
+	struct HeadVertex {
+		HeadVertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, HeadProgram::Kind Kind_) :
+			Position(Position_), Color(Color_), Kind(Kind_) { }
+		glm::vec3 Position; //(z is used by HeadProgram::Alive vertices)
 		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
+		uint8_t Kind;
+		uint8_t padding[3] = {0, 0, 0};
+	};
+	static_assert(sizeof(HeadVertex) == 4*3 + 1*4 + 1*4, "BobMode::HeadVertex should be packed");
+
+	//...with each head's look supplied per instance (streamed every frame):
+	struct HeadInstance {
+		glm::vec2 Center;
+		glm::vec2 Hair; //length, cut angle
+		float Happiness;
+		uint8_t ColorIndex;
+		uint8_t Dead;
+		uint8_t padding[2];
 	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "BobMode::Vertex should be packed");
+	static_assert(sizeof(HeadInstance) == 4*2 + 4*2 + 4*1 + 1*4, "BobMode::HeadInstance should be packed");
+	std::vector< HeadInstance > head_instances; //(kept between frames to avoid reallocating)
 
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
+	//Shader program that draws head instances:
+	HeadProgram head_program;
 
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
+	//Buffer holding the head mesh (never changes after construction):
+	GLuint head_mesh_buffer = 0;
+	GLsizei head_mesh_count = 0;
 
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	//Vertex Array Object that maps the head mesh and the streamed instances to head_program attribute locations:
+	// (instance attributes are re-pointed at each frame's data in draw())
+	GLuint head_vertex_array = 0;
 
-	//Solid white texture:
-	GLuint white_tex = 0;
+	//matrix that maps from court-space coordinates to clip coordinates for a given aspect ratio;
+	// also (optionally) computes its inverse:
+	glm::mat4 court_to_clip(float aspect, glm::mat3x2 *clip_to_court = nullptr) const;
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
-	// (stored here so that the mouse handling code can use it to position the paddle)
+	// computed in handle_event() from the window size, rather than in draw(),
+	// so that mouse handling does not depend on rendering (e.g., when replaying input logs)
 
 };
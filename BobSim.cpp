@@ -0,0 +1,299 @@
+#include "BobSim.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void BobSim::Heads::push_back(glm::vec2 const &position, float length) {
+	x.emplace_back(position.x);
+	y.emplace_back(position.y);
+	prev_x.emplace_back(position.x);
+	prev_y.emplace_back(position.y);
+	vx.emplace_back(0.0f);
+	vy.emplace_back(0.0f);
+	hair_length.emplace_back(length);
+	hair_angle.emplace_back(0.0f);
+	happiness.emplace_back(-1.0f);
+	vis_elapsed.emplace_back(0.0f);
+	cut_elapsed.emplace_back(0.0f);
+	flags.emplace_back(uint8_t(0));
+}
+
+BobSim::BobSim(uint32_t seed, uint32_t num_heads_) : rng(seed), effects_rng(seed, 1) {
+	num_heads = int(num_heads_);
+
+	//create initial heads in evenly-spaced columns
+	// (the default four land at x = -2.5, 0, 2.5, 5):
+	for (uint32_t i = 0; i < num_heads_; ++i) {
+		float x = -2.5f + (num_heads_ > 1 ? 7.5f * i / float(num_heads_ - 1) : 0.0f);
+		float y = 0.0f;
+		//stress-test crowds get scattered vertically so they don't all move in lockstep:
+		if (num_heads_ > 4) y = court_radius.y - head_radius.y - rng.unit() * 2.0f * (court_radius.y - head_radius.y);
+		heads.push_back(glm::vec2(x, y), default_hair_length);
+	}
+
+	//heads are bucketed into cells about a head across for collision tests:
+	head_grid.reset(-court_radius, court_radius, 2.0f * head_radius.x);
+
+	//every other head starts out visible, alternating direction:
+	for (uint32_t i = 1; i < num_heads_; i += 2) {
+		heads.vy[i] = ((i / 2) % 2 == 0 ? max_head_speed : -max_head_speed);
+		heads.flags[i] |= Heads::Visible;
+		++num_visible;
+	}
+	hidden_heads.reserve(num_heads_);
+	leaving_heads.reserve(num_heads_);
+	for (uint32_t i = 0; i < num_heads_; ++i) {
+		if (!heads.visible(i)) hidden_heads.emplace_back(i);
+	}
+}
+
+void BobSim::set_fire_mode(FireMode mode) {
+	fire_mode = mode;
+	//classic play allows only one knife in the air:
+	max_knives = (mode == FireMode::Single ? 1 : knives.capacity);
+	rapid_elapsed = 0.0f;
+}
+
+void BobSim::aim(glm::vec2 const &court_target) {
+	//(knives already in flight keep their headings)
+	knife_angle = std::atan2(court_target.y - knife_start.y, court_target.x - knife_start.x);
+}
+
+void BobSim::press_trigger() {
+	if (trigger_held) return;
+	trigger_held = true;
+	if (fire_mode == FireMode::Spread) {
+		float first = knife_angle - 0.5f * (spread_count - 1) * spread_angle;
+		for (uint32_t i = 0; i < spread_count && knife_ready(); ++i) {
+			throw_knife(knife_start, first + i * spread_angle);
+		}
+	} else if (knife_ready()) {
+		throw_knife(knife_start, knife_angle);
+		rapid_elapsed = 0.0f;
+	}
+}
+
+void BobSim::release_trigger() {
+	trigger_held = false;
+}
+
+void BobSim::throw_knife(glm::vec2 const &at, float angle) {
+	knives.spawn(at, knife_speed * glm::vec2(std::cos(angle), std::sin(angle)), angle);
+}
+
+void BobSim::update(float elapsed) {
+
+	//remember where things were, so drawing can interpolate between updates:
+	std::copy(heads.x.begin(), heads.x.end(), heads.prev_x.begin());
+	std::copy(heads.y.begin(), heads.y.end(), heads.prev_y.begin());
+
+	//keep throwing while the trigger is held in rapid-fire mode:
+	if (fire_mode == FireMode::Rapid && trigger_held) {
+		rapid_elapsed += elapsed;
+		while (rapid_elapsed >= rapid_interval) {
+			rapid_elapsed -= rapid_interval;
+			if (knife_ready()) throw_knife(knife_start, knife_angle);
+		}
+	}
+
+	//severed hair keeps falling even after the game is over:
+	hairs.integrate(elapsed, hair_gravity);
+	//drop strands once they are entirely below the court:
+	hairs.despawn_if([this](size_t h) {
+		return hairs.y[h] + 0.5f * hairs.length[h] < -court_radius.y;
+	});
+
+	//update knife positions (integrate() also remembers previous positions):
+	knives.integrate(elapsed);
+	//drop knives once they are entirely offscreen:
+	knives.despawn_outside(-court_radius - knife_radius, court_radius + knife_radius);
+
+	if (lives == 0) return;
+
+	//spawn new heads
+	if (add_heads > 0 && !hidden_heads.empty()) {
+		add_elapsed += elapsed;
+		if (add_elapsed > reappear_time) {
+			spawn_head();
+		}
+	}
+
+	update_heads(elapsed);
+}
+
+void BobSim::spawn_head() {
+	//take a random head off the hidden list:
+	uint32_t pick = rng.below(uint32_t(hidden_heads.size()));
+	uint32_t i = hidden_heads[pick];
+	hidden_heads[pick] = hidden_heads.back();
+	hidden_heads.pop_back();
+
+	num_visible++;
+	add_heads--;
+	add_elapsed = 0.0f;
+	heads.flags[i] = Heads::Visible;
+	heads.vy[i] = max_head_speed;
+	if (rng.unit() < 0.5f) heads.vy[i] *= -1;
+	heads.hair_length[i] = default_hair_length;
+	heads.happiness[i] = -1;
+	heads.hair_angle[i] = 0;
+	heads.y[i] = court_radius.y - rng.unit() * court_radius.y * 2;
+	heads.prev_y[i] = heads.y[i]; //(teleport -- don't interpolate)
+}
+
+//moves, bounces, and ages every head in one branch-free pass; returns the number of heads that disappeared.
+//written so that the compiler can vectorize it:
+// - arrays are passed as __restrict parameters so the compiler needn't check for overlap between them
+// - conditions are computed as 0/1 ints and combined with '&' / '|' rather than '&&' / '||'
+static int move_heads(
+	float *__restrict x, float *__restrict y, float const *__restrict vx, float *__restrict vy,
+	float const *__restrict happiness, float *__restrict vis_elapsed, float *__restrict cut_elapsed, uint8_t *__restrict flags,
+	size_t count, float elapsed, float bottom, float top, float happy_threshold, float disappear_time) {
+
+	static_assert(BobSim::Heads::Visible == 1 && BobSim::Heads::Dead == 2, "move_heads assumes flag bit positions");
+
+	int hidden = 0;
+	for (size_t i = 0; i < count; ++i) {
+		int f = flags[i];
+		int visible = f & 1;
+		//dead heads, and heads with a good enough haircut, stop and fade out:
+		int satisfied = int(happiness[i] > happy_threshold);
+		int leaving = ((f >> 1) & 1) | satisfied;
+		int moving = visible & (leaving ^ 1);
+		int fading = visible & leaving;
+
+		x[i] += float(moving) * elapsed * vx[i];
+		y[i] += float(moving) * elapsed * vy[i];
+		cut_elapsed[i] += float(moving) * elapsed;
+		vis_elapsed[i] += float(fading) * elapsed;
+
+		//bounce off top and bottom
+		float v = vy[i];
+		float speed = std::abs(v);
+		v = (moving & int(y[i] < bottom)) ? speed : v;
+		v = (moving & int(y[i] > top)) ? -speed : v;
+		vy[i] = v;
+
+		//disappear once done fading:
+		int gone = fading & int(vis_elapsed[i] > disappear_time);
+		flags[i] = uint8_t(f & ~gone);
+		hidden += gone;
+	}
+	return hidden;
+}
+
+void BobSim::update_heads(float elapsed) {
+	size_t const count = heads.size();
+
+	//----- movement + timers -----
+	int hidden = move_heads(
+		heads.x.data(), heads.y.data(), heads.vx.data(), heads.vy.data(),
+		heads.happiness.data(), heads.vis_elapsed.data(), heads.cut_elapsed.data(), heads.flags.data(),
+		count, elapsed,
+		-court_radius.y + head_radius.y, //lowest center before bouncing up
+		court_radius.y - head_radius.x, //highest center before bouncing down
+		happy_threshold, disappear_time
+	);
+	num_visible -= hidden;
+
+	//move heads that just finished fading out onto the hidden list
+	// (only leaving heads can disappear, so there's no need to look at the rest):
+	if (hidden > 0) {
+		for (size_t l = leaving_heads.size(); l > 0; --l) {
+			uint32_t i = leaving_heads[l - 1];
+			if (heads.visible(i)) continue;
+			hidden_heads.emplace_back(i);
+			leaving_heads[l - 1] = leaving_heads.back();
+			leaving_heads.pop_back();
+		}
+	}
+
+	//----- broadphase -----
+	//bucket the heads that can currently be cut (i.e., moving ones) by position:
+	{
+		float const happy = happy_threshold;
+		head_grid.build(heads.x.data(), heads.y.data(), count, [&](size_t i) {
+			return heads.flags[i] == Heads::Visible && heads.happiness[i] <= happy;
+		});
+	}
+
+	//----- knife collision -----
+	for (size_t k = 0; k < knives.size() && lives > 0; ++k) {
+		knife_vs_heads(knives.position(k), knives.angle[k]);
+	}
+}
+
+void BobSim::knife_vs_heads(glm::vec2 const &at, float angle) {
+	//knife tip, computed once (rather than per head):
+	glm::vec2 dir = glm::vec2(std::cos(angle), std::sin(angle));
+	glm::vec2 tip = at + knife_radius.x * dir;
+	//height at which hair gets cut:
+	float cut_y = at.y + .5f * knife_radius.x * dir.y;
+
+	//the tip can only touch heads whose centers are within a head radius horizontally,
+	// and between a head radius above and a head radius plus the longest hair below:
+	glm::vec2 lo = glm::vec2(tip.x - head_radius.x, tip.y - head_radius.y);
+	glm::vec2 hi = glm::vec2(tip.x + head_radius.x, tip.y + head_radius.y + default_hair_length);
+
+	head_grid.query(lo, hi, [&](uint32_t i) {
+		//(in a big crowd one tip can be over several heads; once the game is lost, the rest don't count)
+		if (lives == 0) return;
+		//check for collision with knife point horizontally
+		if (tip.x <= heads.x[i] - head_radius.x || tip.x >= heads.x[i] + head_radius.x) return;
+		//(a head may already have been hit by an earlier knife this update)
+		if (heads.flags[i] != Heads::Visible || heads.happiness[i] > happy_threshold) return;
+		if (heads.cut_elapsed[i] <= cut_time) return;
+		//if it is below the top of the head
+		if (tip.y >= heads.y[i] + head_radius.y) return;
+
+		//if it hits the head
+		if (tip.y > heads.y[i] - head_radius.y) {
+			heads.flags[i] |= Heads::Dead;
+			heads.vis_elapsed[i] = 0.0f;
+			heads.happiness[i] = -1;
+			leaving_heads.emplace_back(i);
+			lives -= 1;
+			add_heads++;
+		}
+		//if it hits the hair
+		else if (tip.y > heads.y[i] - head_radius.y - heads.hair_length[i]) {
+			float old_bottom = heads.y[i] - head_radius.y - heads.hair_length[i];
+			heads.hair_length[i] = std::max(0.01f, heads.y[i] - head_radius.y - cut_y);
+			cut_hair(i, old_bottom, dir);
+			heads.hair_angle[i] = angle;
+			heads.happiness[i] = 1.0f - heads.hair_length[i] / default_hair_length * 2.0f;
+
+			heads.cut_elapsed[i] = 0.0f;
+			if (heads.vy[i] > 0) {
+				heads.vy[i] = min_head_speed + (max_head_speed - min_head_speed) * (1.0f - heads.happiness[i]) / 2.0f;
+			}
+			if (heads.happiness[i] > happy_threshold) {
+				heads.vis_elapsed[i] = 0.0f;
+				leaving_heads.emplace_back(i);
+				score++;
+				max_head_speed = std::max(2.0f + score / 5.0f, 6.0f);
+				add_heads++;
+			}
+		}
+	});
+}
+
+void BobSim::cut_hair(size_t i, float old_bottom, glm::vec2 const &knife_dir) {
+	float top = heads.y[i] - head_radius.y - heads.hair_length[i];
+	float length = top - old_bottom;
+	if (length <= 0.0f) return;
+
+	//the severed hair falls as a row of strands across the width of the head,
+	// carried along by the head and nudged by the knife:
+	auto rand01 = [this]() { return effects_rng.unit(); };
+	float width = 2.0f * head_radius.x;
+	for (uint32_t s = 0; s < strands_per_cut; ++s) {
+		glm::vec2 at = glm::vec2(
+			heads.x[i] - head_radius.x + width * (s + 0.5f) / float(strands_per_cut),
+			old_bottom + 0.5f * length
+		);
+		glm::vec2 vel = glm::vec2(0.0f, heads.vy[i]) + (1.0f + 2.0f * rand01()) * knife_dir
+			+ glm::vec2(rand01() - 0.5f, rand01());
+		hairs.spawn(at, vel, 0.2f * (rand01() - 0.5f), 6.0f * (rand01() - 0.5f), length);
+	}
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "UniformGrid.hpp"
+#include "ProjectilePool.hpp"
+#include "Rng.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * BobSim holds the state of a game of Bob and advances it through time.
+ * It does not touch SDL or OpenGL, so it can run without a window
+ *  (BobMode wraps it for play; bob_sim.cpp drives it headless for benchmarking).
+ */
+
+struct BobSim {
+	//games with the same seed and the same input play out identically:
+	// (num_heads other than the default spreads heads across the court for stress testing)
+	BobSim(uint32_t seed = 0, uint32_t num_heads = 4);
+
+	//----- input -----
+
+	//how pulling the trigger throws knives:
+	enum class FireMode : uint8_t {
+		Single, //one knife at a time; the next can't be thrown until it leaves the court
+		Rapid, //a stream of knives for as long as the trigger is held
+		Spread, //a fan of knives per pull
+	};
+	void set_fire_mode(FireMode mode);
+
+	//point the knife at a location in court space:
+	void aim(glm::vec2 const &court_target);
+
+	//pull / release the trigger:
+	void press_trigger();
+	void release_trigger();
+
+	//can another knife be thrown right now?
+	bool knife_ready() const { return knives.size() < max_knives; }
+
+	//throw a knife from 'at' with heading 'angle' (does nothing if the pool is full):
+	void throw_knife(glm::vec2 const &at, float angle);
+
+	//----- simulation -----
+
+	//advance the game by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//helpers used by update():
+	void spawn_head(); //reveals a random hidden head
+	void update_heads(float elapsed);
+	void knife_vs_heads(glm::vec2 const &knife, float knife_angle); //needs head_grid to be current
+	void cut_hair(size_t head, float old_bottom, glm::vec2 const &knife_dir); //spawns hair strands for a cut
+
+	//----- game state -----
+
+	Rng rng; //per-game pseudo-random number generator (never use std::rand here)
+
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+
+	glm::vec2 knife_start = glm::vec2(-6.5f, 0.0f);
+	glm::vec2 knife_radius = glm::vec2(1.0f, .05f);
+	float knife_angle = 0.0f; //aim of the knife in hand
+	float knife_speed = 60.0f; //units per second
+
+	FireMode fire_mode = FireMode::Single;
+	bool trigger_held = false;
+	float rapid_interval = 0.05f; //seconds between knives in Rapid mode
+	float rapid_elapsed = 0.0f; //time since the last knife was thrown in Rapid mode
+	uint32_t spread_count = 5; //knives per pull in Spread mode
+	float spread_angle = 0.12f; //radians between neighboring knives in Spread mode
+
+	//knives in flight (allocated once, here, so throwing never allocates):
+	ProjectilePool knives = ProjectilePool(1024);
+	size_t max_knives = 1; //in-flight limit for the current fire mode
+
+	uint32_t lives = 3;
+	uint32_t score = 0;
+
+	float default_hair_length = 2.0f;
+	float disappear_time = 1.0f;
+	float reappear_time = 1.5f;
+	float happy_threshold = 0.66f;
+	float cut_time = 0.4f;
+
+	int num_visible = 0;
+	int num_heads = 0;
+	int add_heads = 0;
+	float add_elapsed = 0.0f;
+
+	glm::vec2 head_radius = glm::vec2(0.8f, 0.8f);
+	float min_head_speed = .5f;
+	float max_head_speed = 2.0f;
+
+	//heads are stored as a structure of arrays, so that the update loops
+	// stream through only the fields they need (and can be vectorized):
+	struct Heads {
+		//bits of 'flags':
+		enum : uint8_t {
+			Visible = 1,
+			Dead = 2,
+		};
+
+		std::vector< float > x, y; //position
+		std::vector< float > prev_x, prev_y; //position before the latest update (for interpolation)
+		std::vector< float > vx, vy; //velocity
+		std::vector< float > hair_length;
+		std::vector< float > hair_angle;
+		std::vector< float > happiness; //ranges from -1 to 1
+		std::vector< float > vis_elapsed; //time since being killed or satisfied
+		std::vector< float > cut_elapsed; //time since last haircut
+		std::vector< uint8_t > flags;
+
+		size_t size() const { return flags.size(); }
+		void push_back(glm::vec2 const &position, float hair_length);
+
+		glm::vec2 position(size_t i) const { return glm::vec2(x[i], y[i]); }
+		glm::vec2 prev_position(size_t i) const { return glm::vec2(prev_x[i], prev_y[i]); }
+		bool visible(size_t i) const { return (flags[i] & Visible) != 0; }
+		bool dead(size_t i) const { return (flags[i] & Dead) != 0; }
+	};
+	Heads heads;
+
+	//indices of hidden heads (in no particular order), so spawning needn't search for one:
+	std::vector< uint32_t > hidden_heads;
+	//indices of heads that are fading out (dead or satisfied), which will soon become hidden:
+	std::vector< uint32_t > leaving_heads;
+
+	//heads that can be cut, bucketed by position (rebuilt every update):
+	UniformGrid head_grid;
+
+	//severed hair falls as particles, pooled just like the knives (length is the strand's length, spin its tumbling).
+	//when the pool is full, new strands are simply dropped -- they are only cosmetic.
+	//(a cut makes strands_per_cut strands that fall for a second or two, so even rapid-fire play keeps at most
+	// a few hundred in the air; 4096 leaves plenty of headroom. The 50k-strand budget is a stress target,
+	// measured with bob_sim --hairs, which sizes the pool to match.)
+	ProjectilePool hairs = ProjectilePool(4096);
+	float hair_gravity = -20.0f; //units per second per second
+	uint32_t strands_per_cut = 8;
+
+	//random numbers for cosmetic effects (a separate stream, so that effects don't change gameplay):
+	Rng effects_rng;
+};
@@ -0,0 +1,255 @@
+#include "Capture.hpp"
+
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <csignal>
+#endif
+
+constexpr uint32_t Capture::Slots;
+
+//PNG targets are printf'd with the frame number, so they must hold exactly one '%d' (or '%0Nd', N <= 20)
+// and no other conversions ('%%' is fine) -- anything else would overwrite one file, or worse:
+static bool is_frame_pattern(std::string const &target) {
+	uint32_t conversions = 0;
+	for (size_t i = 0; i < target.size(); ++i) {
+		if (target[i] != '%') continue;
+		++i;
+		if (i < target.size() && target[i] == '%') continue;
+		//optional zero-padded width:
+		uint32_t width = 0;
+		if (i < target.size() && target[i] == '0') {
+			++i;
+			while (i < target.size() && target[i] >= '0' && target[i] <= '9' && width <= 20) {
+				width = width * 10 + uint32_t(target[i] - '0');
+				++i;
+			}
+		}
+		if (width > 20 || i >= target.size() || target[i] != 'd') return false;
+		conversions += 1;
+	}
+	return conversions == 1;
+}
+
+Capture::Capture(std::string const &target_, Format format_, float fps_, bool block_)
+	: target(target_), format(format_), fps(fps_), block(block_), readback(Slots) {
+
+	uint32_t count = 1;
+	if (format == Png) {
+		if (!is_frame_pattern(target)) {
+			throw std::runtime_error("PNG capture target '" + target + "' needs exactly one frame number pattern, and no other '%' (e.g. 'capture/%05d.png').");
+		}
+		//each frame is its own file, so encode several at once:
+		uint32_t cores = std::thread::hardware_concurrency();
+		count = (cores > 2 ? std::min(Slots, cores - 1) : 1);
+	} else if (target.size() > 1 && target[0] == '|') {
+		#ifndef _WIN32
+		//a command that exits early should cause write errors, not kill the game:
+		std::signal(SIGPIPE, SIG_IGN);
+		file = popen(target.c_str() + 1, "w");
+		#else
+		file = popen(target.c_str() + 1, "wb");
+		#endif
+		pipe = true;
+	} else {
+		file = std::fopen(target.c_str(), "wb");
+	}
+	if (format != Png && !file) {
+		throw std::runtime_error("Failed to open capture target '" + target + "'.");
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		writers.emplace_back(&Capture::work, this);
+	}
+}
+
+Capture::~Capture() {
+	finish();
+}
+
+void Capture::finish() {
+	if (finished) return;
+	finished = true;
+
+	//hand over every outstanding readback, then let the writers drain the queue:
+	readback.poll([this](FrameReadback::Frame const &frame){ enqueue(frame); }, true);
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+		wake.notify_all();
+	}
+	for (auto &writer : writers) {
+		writer.join();
+	}
+	if (file) {
+		if (pipe) pclose(file);
+		else std::fclose(file);
+		file = nullptr;
+	}
+}
+
+Capture::Format Capture::format_for(std::string const &target) {
+	auto ends_with = [&target](std::string const &suffix) {
+		return target.size() >= suffix.size() && target.compare(target.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+	if (ends_with(".png")) return Png;
+	if (ends_with(".y4m")) return Y4M;
+	return Raw;
+}
+
+void Capture::frame(glm::uvec2 const &size) {
+	if (format != Png) {
+		if (stream_size == glm::uvec2(0)) stream_size = size;
+		if (size != stream_size) {
+			if (skipped == 0) {
+				std::cerr << "WARNING: window size changed during capture; skipping frames that aren't "
+					<< stream_size.x << "x" << stream_size.y << "." << std::endl;
+			}
+			skipped += 1;
+			return;
+		}
+	}
+
+	while (!readback.read(size, captured)) {
+		if (!block) {
+			if (dropped == 0) std::cerr << "WARNING: capture writers are falling behind; dropping frames." << std::endl;
+			dropped += 1;
+			return;
+		}
+		//wait for a writer to release a buffer:
+		update();
+		std::unique_lock< std::mutex > lock(mutex);
+		released.wait_for(lock, std::chrono::milliseconds(5));
+	}
+	captured += 1;
+}
+
+void Capture::update() {
+	if (readback.busy() == 0) return;
+	readback.poll([this](FrameReadback::Frame const &frame){ enqueue(frame); });
+}
+
+void Capture::enqueue(FrameReadback::Frame const &frame) {
+	std::unique_lock< std::mutex > lock(mutex);
+	queue.emplace_back(frame);
+	wake.notify_one();
+}
+
+//BT.601 (studio range) RGB -> YUV 4:2:0 planes, flipping from lower-left to upper-left origin:
+static void rgba_to_yuv420(glm::uvec2 const &size, glm::u8vec4 const *pixels, std::vector< uint8_t > *yuv_) {
+	auto &yuv = *yuv_;
+	uint32_t cw = (size.x + 1) / 2;
+	uint32_t ch = (size.y + 1) / 2;
+	yuv.resize(size_t(size.x) * size.y + 2 * size_t(cw) * ch);
+	uint8_t *Y = yuv.data();
+	uint8_t *U = Y + size_t(size.x) * size.y;
+	uint8_t *V = U + size_t(cw) * ch;
+
+	for (uint32_t y = 0; y < size.y; ++y) {
+		glm::u8vec4 const *row = pixels + size_t(size.y - 1 - y) * size.x;
+		uint8_t *out = Y + size_t(y) * size.x;
+		for (uint32_t x = 0; x < size.x; ++x) {
+			int32_t r = row[x].r, g = row[x].g, b = row[x].b;
+			out[x] = uint8_t(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+		}
+	}
+
+	for (uint32_t cy = 0; cy < ch; ++cy) {
+		uint32_t y0 = 2 * cy;
+		uint32_t y1 = std::min(y0 + 1, size.y - 1);
+		glm::u8vec4 const *row0 = pixels + size_t(size.y - 1 - y0) * size.x;
+		glm::u8vec4 const *row1 = pixels + size_t(size.y - 1 - y1) * size.x;
+		for (uint32_t cx = 0; cx < cw; ++cx) {
+			uint32_t x0 = 2 * cx;
+			uint32_t x1 = std::min(x0 + 1, size.x - 1);
+			//average the 2x2 block:
+			int32_t r = (row0[x0].r + row0[x1].r + row1[x0].r + row1[x1].r + 2) / 4;
+			int32_t g = (row0[x0].g + row0[x1].g + row1[x0].g + row1[x1].g + 2) / 4;
+			int32_t b = (row0[x0].b + row0[x1].b + row1[x0].b + row1[x1].b + 2) / 4;
+			U[size_t(cy) * cw + cx] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+			V[size_t(cy) * cw + cx] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+		}
+	}
+}
+
+void Capture::work() {
+	std::vector< glm::u8vec4 > pixels; //for Png and Raw
+	std::vector< uint8_t > yuv; //for Y4M
+	while (true) {
+		FrameReadback::Frame frame;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			wake.wait(lock, [this](){ return quit || !queue.empty(); });
+			if (queue.empty()) break; //(quit, and nothing left to do)
+			frame = queue.front();
+			queue.pop_front();
+		}
+		auto before = std::chrono::high_resolution_clock::now();
+
+		//convert out of the mapped buffer, so it can be released right away:
+		size_t count = size_t(frame.size.x) * frame.size.y;
+		if (format == Y4M) {
+			rgba_to_yuv420(frame.size, frame.pixels, &yuv);
+		} else {
+			pixels.resize(count);
+			for (size_t i = 0; i < count; ++i) {
+				pixels[i] = glm::u8vec4(frame.pixels[i].r, frame.pixels[i].g, frame.pixels[i].b, 0xff);
+			}
+		}
+		readback.release(frame.slot);
+		released.notify_one();
+
+		bool ok = true;
+		if (format == Png) {
+			std::vector< char > filename(target.size() + 32);
+			std::snprintf(filename.data(), filename.size(), target.c_str(), int(frame.tag));
+			//(frames are already encoded in parallel, so each uses just one thread)
+			PngSaveOptions options;
+			options.threads = 1;
+			ok = save_png(filename.data(), frame.size, pixels.data(), LowerLeftOrigin, options);
+		} else {
+			//(only one writer for streams, so frames arrive in order)
+			if (format == Y4M) {
+				if (frame.tag == 0) {
+					ok = ok && std::fprintf(file, "YUV4MPEG2 W%u H%u F%u:1000 Ip A1:1 C420jpeg\n",
+						frame.size.x, frame.size.y, uint32_t(fps * 1000.0f + 0.5f)) > 0;
+				}
+				ok = ok && std::fputs("FRAME\n", file) >= 0;
+				ok = ok && std::fwrite(yuv.data(), 1, yuv.size(), file) == yuv.size();
+			} else {
+				//flip to top-to-bottom rows:
+				for (uint32_t y = 0; ok && y < frame.size.y; ++y) {
+					ok = std::fwrite(&pixels[size_t(frame.size.y - 1 - y) * frame.size.x], sizeof(glm::u8vec4), frame.size.x, file) == frame.size.x;
+				}
+			}
+		}
+
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+		std::unique_lock< std::mutex > lock(mutex);
+		write_time += seconds;
+		if (ok) {
+			written += 1;
+		} else if (!write_failed) {
+			write_failed = true;
+			std::cerr << "WARNING: failed writing capture to '" << target << "'." << std::endl;
+		}
+	}
+}
+
+void Capture::report(std::ostream &out) const {
+	out << "Captured " << captured << " frames to '" << target << "'";
+	std::unique_lock< std::mutex > lock(mutex);
+	out << " (" << written << " written, " << (written ? write_time / written * 1e3 : 0.0) << " ms each across "
+		<< writers.size() << " writer" << (writers.size() == 1 ? "" : "s") << ")";
+	if (dropped) out << "; dropped " << dropped << " frames because the writers fell behind";
+	if (skipped) out << "; skipped " << skipped << " frames of the wrong size";
+	out << "." << std::endl;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "FrameReadback.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Capture records every drawn frame, for offline encoding.
+ *
+ * Frames are read back through a ring of pixel-pack buffers (FrameReadback);
+ *  finished readbacks wait in a queue (bounded by the ring size) for writer
+ *  threads, which convert each frame out of its mapped buffer, release it,
+ *  and write it out:
+ *   - Png: one file per frame, named by printf-ing the frame number into the
+ *     target (e.g., "capture/%05d.png" -- exactly one %d or %0Nd, and no
+ *     other conversions); frames are encoded in parallel.
+ *   - Y4M: a YUV4MPEG2 stream (4:2:0, BT.601) -- e.g. for ffmpeg -i out.y4m.
+ *   - Raw: tightly packed top-to-bottom RGBA8 frames.
+ *  Y4M and Raw write to a file, or -- if the target starts with '|' -- to the
+ *  standard input of a command (e.g. "|ffmpeg -f yuv4mpegpipe -i - out.mp4").
+ *
+ * If the writers fall behind and every buffer is in use, frames are dropped
+ *  (and counted) rather than stalling the render loop -- unless 'block' is set,
+ *  in which case frame() waits (useful when capturing a replay).
+ */
+
+struct Capture {
+	enum Format {
+		Png,
+		Y4M,
+		Raw,
+	};
+
+	//NOTE: throws if the target can't be opened:
+	Capture(std::string const &target, Format format, float fps, bool block = false);
+	~Capture();
+
+	//wait until every frame captured so far is written, and close the target (called by the destructor):
+	void finish();
+
+	//guess a format from a target's extension (".png" -> Png, ".y4m" -> Y4M, anything else -> Raw):
+	static Format format_for(std::string const &target);
+
+	//capture the back buffer's lower-left 'size' pixels (call after drawing, before swapping):
+	void frame(glm::uvec2 const &size);
+
+	//call once per frame:
+	void update();
+
+	//print a summary of frames captured, dropped, and written:
+	void report(std::ostream &out) const;
+
+	std::string target;
+	Format format;
+	float fps; //only labels the Y4M stream -- frames are captured whenever frame() is called
+	bool block;
+
+	//buffers in flight (at 1080p, each is about 8MB):
+	static constexpr uint32_t Slots = 6;
+	FrameReadback readback;
+
+	//size of the stream's frames (Y4M and Raw streams can't change size; frames of other sizes are skipped):
+	glm::uvec2 stream_size = glm::uvec2(0);
+
+	//----- statistics -----
+	uint64_t captured = 0; //frames read back (also the number of the next frame)
+	uint64_t dropped = 0; //frames skipped because every buffer was busy
+	uint64_t skipped = 0; //frames skipped because they were the wrong size
+	uint64_t written = 0; //frames written out (guarded by 'mutex')
+	double write_time = 0.0; //seconds spent by writers (guarded by 'mutex')
+
+	//----- writers -----
+	FILE *file = nullptr; //for Y4M and Raw
+	bool pipe = false; //'file' came from popen()
+	std::vector< std::thread > writers;
+	mutable std::mutex mutex; //guards everything below
+	std::condition_variable wake; //a frame is ready (or it's time to quit)
+	std::condition_variable released; //a buffer was released
+	std::deque< FrameReadback::Frame > queue; //mapped readbacks waiting for a writer
+	bool quit = false;
+	bool write_failed = false;
+	bool finished = false;
+
+private:
+	void enqueue(FrameReadback::Frame const &frame);
+	void work();
+};
@@ -0,0 +1,45 @@
+#include "ColorProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+ColorProgram::ColorProgram(GLProgramBatch *batch) {
+	GLProgramBatch now; //(finishes right here, if not given a batch)
+	//like ColorTextureProgram, but without the texture lookup (and the attribute that feeds it):
+	program = (batch ? batch : &now)->add(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec4 Position;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	, [this](GLuint) {
+		//(runs once the program has linked)
+		//look up the locations of vertex attributes:
+		Position_vec4 = glGetAttribLocation(program, "Position");
+		Color_vec4 = glGetAttribLocation(program, "Color");
+
+		//look up the locations of uniforms:
+		OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	});
+	now.finish();
+}
+
+ColorProgram::~ColorProgram() {
+	gl_state.deleted_program(program);
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "GL.hpp"
+
+struct GLProgramBatch;
+
+//Shader program that draws transformed, vertex-colored vertices (no texture):
+struct ColorProgram {
+	//compiles right away, or (if given a batch) once the batch is finished:
+	ColorProgram(GLProgramBatch *batch = nullptr);
+	~ColorProgram();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U;
+	GLuint Color_vec4 = -1U;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+};
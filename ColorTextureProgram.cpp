@@ -1,11 +1,13 @@
 #include "ColorTextureProgram.hpp"
 
 #include "gl_compile_program.hpp"
+#include "GLState.hpp"
 #include "gl_errors.hpp"
 
-ColorTextureProgram::ColorTextureProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+ColorTextureProgram::ColorTextureProgram(GLProgramBatch *batch) {
+	GLProgramBatch now; //(finishes right here, if not given a batch)
+	//Compile vertex and fragment shaders using the convenient 'GLProgramBatch' helper (see gl_compile_program.hpp):
+	program = (batch ? batch : &now)->add(
 		//vertex shader:
 		"#version 330\n"
 		"uniform mat4 OBJECT_TO_CLIP;\n"
@@ -29,28 +31,29 @@ ColorTextureProgram::ColorTextureProgram() {
 		"void main() {\n"
 		"	fragColor = texture(TEX, texCoord) * color;\n"
 		"}\n"
-	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
-
-	//look up the locations of vertex attributes:
-	Position_vec4 = glGetAttribLocation(program, "Position");
-	Color_vec4 = glGetAttribLocation(program, "Color");
-	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
-
-	//look up the locations of uniforms:
-	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
-	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
-
-	//set TEX to always refer to texture binding zero:
-	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
-
-	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
-
-	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+	, [this](GLuint) {
+		//(runs once the program has linked)
+		//look up the locations of vertex attributes:
+		Position_vec4 = glGetAttribLocation(program, "Position");
+		Color_vec4 = glGetAttribLocation(program, "Color");
+		TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
+
+		//look up the locations of uniforms:
+		OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+		GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
+
+		//set TEX to always refer to texture binding zero:
+		gl_state.use_program(program); //bind program -- glUniform* calls refer to this program now
+
+		glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
+	});
+	now.finish();
 }
 
 ColorTextureProgram::~ColorTextureProgram() {
+	gl_state.deleted_program(program);
 	glDeleteProgram(program);
 	program = 0;
 }
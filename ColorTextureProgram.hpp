@@ -2,9 +2,12 @@
 
 #include "GL.hpp"
 
+struct GLProgramBatch;
+
 //Shader program that draws transformed, textured vertices tinted with vertex colors:
 struct ColorTextureProgram {
-	ColorTextureProgram();
+	//compiles right away, or (if given a batch) once the batch is finished:
+	ColorTextureProgram(GLProgramBatch *batch = nullptr);
 	~ColorTextureProgram();
 
 	GLuint program = 0;
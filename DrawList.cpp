@@ -0,0 +1,118 @@
+#include "DrawList.hpp"
+
+#include <cmath>
+
+//points around the unit circle (the last repeats the first), shared by every circle() call:
+static std::vector< glm::vec2 > const &unit_circle() {
+	static std::vector< glm::vec2 > points = [](){
+		std::vector< glm::vec2 > ret;
+		ret.reserve(DrawList::circle_segments + 1);
+		for (uint32_t i = 0; i <= DrawList::circle_segments; ++i) {
+			float angle = i * (2.0f * 3.1415926f / DrawList::circle_segments);
+			ret.emplace_back(std::cos(angle), std::sin(angle));
+		}
+		ret.back() = ret.front(); //close exactly
+		return ret;
+	}();
+	return points;
+}
+
+void DrawList::triangle(glm::vec2 const &a, glm::vec2 const &b, glm::vec2 const &c, glm::u8vec4 const &color) {
+	only_quads = false;
+	uint16_t i = begin_shape(3);
+	add_vertex(a, color);
+	add_vertex(b, color);
+	add_vertex(c, color);
+	index_triangle(i, i+1, i+2);
+}
+
+void DrawList::quad(glm::vec2 const &p1, glm::vec2 const &p2, glm::vec2 const &p3, glm::vec2 const &p4, glm::u8vec4 const &color) {
+	uint16_t i = begin_shape(4);
+	add_vertex(p1, color);
+	add_vertex(p2, color);
+	add_vertex(p3, color);
+	add_vertex(p4, color);
+	//as two CCW-oriented triangles (in the pattern that 'only_quads' promises):
+	index_triangle(i, i+1, i+2);
+	index_triangle(i, i+2, i+3);
+}
+
+void DrawList::rectangle(glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+	quad(
+		glm::vec2(center.x-radius.x, center.y-radius.y),
+		glm::vec2(center.x+radius.x, center.y-radius.y),
+		glm::vec2(center.x+radius.x, center.y+radius.y),
+		glm::vec2(center.x-radius.x, center.y+radius.y),
+		color
+	);
+}
+
+void DrawList::rectangle(glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::u8vec4 const &color) {
+	//rotated half-extents:
+	glm::vec2 x = radius.x * glm::vec2(std::cos(angle), std::sin(angle));
+	glm::vec2 y = radius.y * glm::vec2(-std::sin(angle), std::cos(angle));
+	quad(center - x - y, center + x - y, center + x + y, center - x + y, color);
+}
+
+void DrawList::rectangles(glm::vec2 const *centers, size_t count, glm::vec2 const &radius, glm::u8vec4 const &color) {
+	reserve(4 * count);
+	for (size_t i = 0; i < count; ++i) {
+		rectangle(centers[i], radius, color);
+	}
+}
+
+void DrawList::circle(glm::vec2 const &center, float radius, glm::u8vec4 const &color) {
+	only_quads = false;
+	std::vector< glm::vec2 > const &unit = unit_circle();
+	//center, then each point around the edge once:
+	uint16_t c = begin_shape(1 + circle_segments);
+	add_vertex(center, color);
+	for (uint32_t i = 0; i < circle_segments; ++i) {
+		add_vertex(center + radius * unit[i], color);
+	}
+	for (uint32_t i = 0; i < circle_segments; ++i) {
+		index_triangle(c, uint16_t(c + 1 + i), uint16_t(c + 1 + (i + 1) % circle_segments));
+	}
+}
+
+void DrawList::sector(glm::vec2 const &center, float radius, float start_angle, float angle_elapsed, glm::u8vec4 const &color) {
+	only_quads = false;
+	//walk around the arc by repeatedly rotating by one step (two sin/cos pairs per sector, not per vertex):
+	float step = angle_elapsed / circle_segments;
+	glm::vec2 rot = glm::vec2(std::cos(step), std::sin(step));
+	glm::vec2 d = radius * glm::vec2(std::cos(start_angle), std::sin(start_angle));
+
+	//center, then circle_segments + 1 points along the arc:
+	uint16_t c = begin_shape(2 + circle_segments);
+	add_vertex(center, color);
+	for (uint32_t i = 0; i <= circle_segments; ++i) {
+		add_vertex(center + d, color);
+		d = glm::vec2(d.x * rot.x - d.y * rot.y, d.x * rot.y + d.y * rot.x);
+	}
+	for (uint32_t i = 0; i < circle_segments; ++i) {
+		index_triangle(c, uint16_t(c + 1 + i), uint16_t(c + 2 + i));
+	}
+}
+
+void DrawList::textured_rectangle(glm::vec2 const &center, glm::vec2 const &radius, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color) {
+	uint16_t i = begin_shape(4);
+	add_vertex(glm::vec2(center.x-radius.x, center.y-radius.y), color, glm::vec2(uv_min.x, uv_min.y));
+	add_vertex(glm::vec2(center.x+radius.x, center.y-radius.y), color, glm::vec2(uv_max.x, uv_min.y));
+	add_vertex(glm::vec2(center.x+radius.x, center.y+radius.y), color, glm::vec2(uv_max.x, uv_max.y));
+	add_vertex(glm::vec2(center.x-radius.x, center.y+radius.y), color, glm::vec2(uv_min.x, uv_max.y));
+	index_triangle(i, i+1, i+2);
+	index_triangle(i, i+2, i+3);
+}
+
+void DrawList::textured_rectangle(glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color) {
+	//rotated half-extents:
+	glm::vec2 x = radius.x * glm::vec2(std::cos(angle), std::sin(angle));
+	glm::vec2 y = radius.y * glm::vec2(-std::sin(angle), std::cos(angle));
+	uint16_t i = begin_shape(4);
+	add_vertex(center - x - y, color, glm::vec2(uv_min.x, uv_min.y));
+	add_vertex(center + x - y, color, glm::vec2(uv_max.x, uv_min.y));
+	add_vertex(center + x + y, color, glm::vec2(uv_max.x, uv_max.y));
+	add_vertex(center - x + y, color, glm::vec2(uv_min.x, uv_max.y));
+	index_triangle(i, i+1, i+2);
+	index_triangle(i, i+2, i+3);
+}
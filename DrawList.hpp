@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+/*
+ * DrawList accumulates 2D shapes as indexed triangles (CCW) for a mode to
+ *  upload and draw at once (see DrawListRenderer).
+ *
+ * Vertices are compact (2D position + packed color, 12 bytes). Texture
+ *  coordinates are a separate, optional stream: it stays empty (and
+ *  DrawListRenderer uses the untextured ColorProgram) unless a textured
+ *  shape is added, after which every vertex gets one (and
+ *  ColorTextureProgram is used, with untextured shapes sampling 'solid_uv').
+ *
+ * Each shape stores its distinct vertices once and refers to them with 16-bit
+ *  indices, so a rectangle is 4 vertices rather than 6 and a circle shares its
+ *  center among all of its triangles. Indices are relative to the start of
+ *  their batch; a new batch starts whenever one would need more than 65536 vertices.
+ *
+ * Keep one per mode and clear() it each frame: storage keeps its capacity,
+ *  so steady-state frames don't allocate. If you know roughly how much you
+ *  are about to add, reserve() it first.
+ *
+ * DrawList does not touch OpenGL.
+ */
+
+struct DrawList {
+	struct Vertex {
+		Vertex() = default;
+		Vertex(glm::vec2 const &Position_, glm::u8vec4 const &Color_) :
+			Position(Position_), Color(Color_) { }
+		glm::vec2 Position;
+		glm::u8vec4 Color;
+	};
+	static_assert(sizeof(Vertex) == 4*2 + 1*4, "DrawList::Vertex should be packed");
+
+	//a run of indices that all refer to vertices starting at base_vertex:
+	struct Batch {
+		uint32_t first_index;
+		uint32_t index_count;
+		uint32_t base_vertex;
+	};
+
+	std::vector< Vertex > vertices;
+	std::vector< glm::vec2 > tex_coords; //empty, or one per vertex (see 'textured')
+	std::vector< uint16_t > indices;
+	std::vector< Batch > batches;
+
+	//true once a textured shape has been added (since the last clear()):
+	bool textured = false;
+	//texture coordinate given to untextured shapes in a textured list -- the texture should be white there:
+	glm::vec2 solid_uv = glm::vec2(0.5f, 0.5f);
+
+	//true if everything in the list is a quad, stored as 4 vertices with the standard
+	// {0,1,2, 0,2,3} index pattern -- so a renderer can use a fixed index buffer instead of 'indices':
+	bool only_quads = true;
+
+	static constexpr uint32_t MaxBatchVertices = 0x10000;
+
+	//remove everything (but keep the storage):
+	void clear() {
+		vertices.clear();
+		tex_coords.clear();
+		indices.clear();
+		batches.clear();
+		only_quads = true;
+		textured = false;
+	}
+
+	//make room for 'count' more vertices (and a typical number of indices for them),
+	// so adding them won't reallocate:
+	// (grows geometrically, so calling this before every small shape is still cheap)
+	void reserve(size_t count) {
+		auto grow = [](auto &v, size_t needed) {
+			if (needed > v.capacity()) v.reserve(std::max(needed, 2 * v.capacity()));
+		};
+		grow(vertices, vertices.size() + count);
+		if (textured) grow(tex_coords, tex_coords.size() + count);
+		grow(indices, indices.size() + 3 * count / 2);
+	}
+
+	//----- primitives -----
+
+	void triangle(glm::vec2 const &a, glm::vec2 const &b, glm::vec2 const &c, glm::u8vec4 const &color);
+
+	//quadrilateral with corners in CCW order:
+	void quad(glm::vec2 const &p1, glm::vec2 const &p2, glm::vec2 const &p3, glm::vec2 const &p4, glm::u8vec4 const &color);
+
+	//axis-aligned rectangle:
+	void rectangle(glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color);
+
+	//rectangle rotated by 'angle' (radians, CCW) around its center:
+	void rectangle(glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::u8vec4 const &color);
+
+	//many same-sized, same-colored axis-aligned rectangles at once:
+	void rectangles(glm::vec2 const *centers, size_t count, glm::vec2 const &radius, glm::u8vec4 const &color);
+
+	//full circle (as a fan of circle_segments triangles, using a precomputed table):
+	void circle(glm::vec2 const &center, float radius, glm::u8vec4 const &color);
+
+	//circular sector from 'start_angle' covering 'angle_elapsed' radians (also circle_segments triangles):
+	void sector(glm::vec2 const &center, float radius, float start_angle, float angle_elapsed, glm::u8vec4 const &color);
+
+	//axis-aligned rectangle showing the part of the texture between 'uv_min' and 'uv_max', tinted by 'color':
+	void textured_rectangle(glm::vec2 const &center, glm::vec2 const &radius, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color);
+
+	//...rotated by 'angle' (radians, CCW) around its center:
+	void textured_rectangle(glm::vec2 const &center, glm::vec2 const &radius, float angle, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color);
+
+	static constexpr uint32_t circle_segments = 20;
+
+	//----- for adding new kinds of shapes -----
+
+	//start a shape of 'vertex_count' vertices (at most MaxBatchVertices);
+	// returns the batch-relative index its first vertex will have:
+	uint16_t begin_shape(uint32_t vertex_count) {
+		if (batches.empty() || vertices.size() + vertex_count - batches.back().base_vertex > MaxBatchVertices) {
+			batches.emplace_back(Batch{ uint32_t(indices.size()), 0, uint32_t(vertices.size()) });
+		}
+		return uint16_t(vertices.size() - batches.back().base_vertex);
+	}
+	//add a vertex to the current shape:
+	void add_vertex(glm::vec2 const &position, glm::u8vec4 const &color) {
+		vertices.emplace_back(position, color);
+		if (textured) tex_coords.emplace_back(solid_uv);
+	}
+	void add_vertex(glm::vec2 const &position, glm::u8vec4 const &color, glm::vec2 const &tex_coord) {
+		if (!textured) {
+			//start the texture coordinate stream, with untextured shapes so far sampling 'solid_uv':
+			textured = true;
+			tex_coords.assign(vertices.size(), solid_uv);
+		}
+		vertices.emplace_back(position, color);
+		tex_coords.emplace_back(tex_coord);
+	}
+	//add a triangle to the current shape:
+	void index_triangle(uint16_t a, uint16_t b, uint16_t c) {
+		indices.emplace_back(a);
+		indices.emplace_back(b);
+		indices.emplace_back(c);
+		batches.back().index_count += 3;
+	}
+};
@@ -0,0 +1,146 @@
+#include "DrawListRenderer.hpp"
+
+#include "VertexStream.hpp"
+#include "gl_compile_program.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <vector>
+
+std::shared_ptr< DrawListRenderer > DrawListRenderer::shared;
+
+DrawListRenderer::DrawListRenderer(GLProgramBatch *batch) : color_program(batch), color_texture_program(batch) {
+	//quad index pattern covering a whole batch:
+	std::vector< uint16_t > pattern;
+	pattern.reserve(DrawList::MaxBatchVertices / 4 * 6);
+	for (uint32_t v = 0; v < DrawList::MaxBatchVertices; v += 4) {
+		pattern.emplace_back(uint16_t(v));
+		pattern.emplace_back(uint16_t(v+1));
+		pattern.emplace_back(uint16_t(v+2));
+		pattern.emplace_back(uint16_t(v));
+		pattern.emplace_back(uint16_t(v+2));
+		pattern.emplace_back(uint16_t(v+3));
+	}
+
+	glGenBuffers(1, &quad_indices);
+	//(bound as an array buffer, since element array buffer bindings belong to vertex array objects)
+	glBindBuffer(GL_ARRAY_BUFFER, quad_indices);
+	glBufferData(GL_ARRAY_BUFFER, pattern.size() * sizeof(pattern[0]), pattern.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GL_ERRORS();
+
+	//vertex arrays (attribute pointers are set per-list in draw()), once the programs' locations are known:
+	GLProgramBatch now; //(finishes right here, if not given a batch)
+	(batch ? batch : &now)->then([this]() {
+		glGenVertexArrays(1, &vertex_array_for_color_program);
+		gl_state.bind_vertex_array(vertex_array_for_color_program);
+		glEnableVertexAttribArray(color_program.Position_vec4);
+		glEnableVertexAttribArray(color_program.Color_vec4);
+
+		glGenVertexArrays(1, &vertex_array_for_color_texture_program);
+		gl_state.bind_vertex_array(vertex_array_for_color_texture_program);
+		glEnableVertexAttribArray(color_texture_program.Position_vec4);
+		glEnableVertexAttribArray(color_texture_program.Color_vec4);
+		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+
+		gl_state.bind_vertex_array(0);
+
+		GL_ERRORS();
+	});
+	now.finish();
+}
+
+DrawListRenderer::~DrawListRenderer() {
+	glDeleteBuffers(1, &quad_indices);
+	quad_indices = 0;
+
+	gl_state.deleted_vertex_array(vertex_array_for_color_program);
+	glDeleteVertexArrays(1, &vertex_array_for_color_program);
+	vertex_array_for_color_program = 0;
+
+	gl_state.deleted_vertex_array(vertex_array_for_color_texture_program);
+	glDeleteVertexArrays(1, &vertex_array_for_color_texture_program);
+	vertex_array_for_color_texture_program = 0;
+}
+
+void DrawListRenderer::draw(DrawList const &list, glm::mat4 const &object_to_clip, GLuint texture) {
+	if (list.vertices.empty()) return;
+
+	VertexStream &stream = *VertexStream::shared;
+
+	//----- upload -----
+	//(reserved all at once, so the buffer can't grow -- orphaning the vertices -- between these uploads)
+	stream.reserve(list.vertices.size() * sizeof(DrawList::Vertex) + 4
+		+ (list.textured ? list.tex_coords.size() * sizeof(glm::vec2) + 4 : 0)
+		+ (list.only_quads ? 0 : list.indices.size() * sizeof(uint16_t) + sizeof(uint16_t)));
+	GLintptr vertex_offset = stream.upload(list.vertices.data(), list.vertices.size() * sizeof(DrawList::Vertex), 4);
+	stats.lists += 1;
+	stats.vertex_bytes += list.vertices.size() * sizeof(DrawList::Vertex);
+	stats.unindexed_bytes += list.indices.size() * (4*3 + 1*4 + 4*2);
+
+	GLintptr tex_coord_offset = 0;
+	if (list.textured) {
+		tex_coord_offset = stream.upload(list.tex_coords.data(), list.tex_coords.size() * sizeof(glm::vec2), 4);
+		stats.textured_lists += 1;
+		stats.vertex_bytes += list.tex_coords.size() * sizeof(glm::vec2);
+	}
+
+	GLintptr index_offset = 0;
+	if (!list.only_quads) {
+		index_offset = stream.upload(list.indices.data(), list.indices.size() * sizeof(uint16_t), sizeof(uint16_t));
+		stats.index_bytes += list.indices.size() * sizeof(uint16_t);
+	}
+
+	//----- pick program and point attributes at this list's data -----
+	//(program, vertex array, and texture go through gl_state, so repeated draws don't re-bind them)
+	GLuint Position_vec4, Color_vec4;
+	if (list.textured) {
+		gl_state.use_program(color_texture_program.program);
+		glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+		gl_state.bind_vertex_array(vertex_array_for_color_texture_program);
+		Position_vec4 = color_texture_program.Position_vec4;
+		Color_vec4 = color_texture_program.Color_vec4;
+	} else {
+		gl_state.use_program(color_program.program);
+		glUniformMatrix4fv(color_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+		gl_state.bind_vertex_array(vertex_array_for_color_program);
+		Position_vec4 = color_program.Position_vec4;
+		Color_vec4 = color_program.Color_vec4;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+	//[Note that it is okay to bind a vec2 input to a vec4 attribute -- z and w will be filled with 0.0 and 1.0 automatically]
+	glVertexAttribPointer(Position_vec4, 2, GL_FLOAT, GL_FALSE, sizeof(DrawList::Vertex), (GLbyte *)0 + vertex_offset + 0);
+	glVertexAttribPointer(Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DrawList::Vertex), (GLbyte *)0 + vertex_offset + 4*2);
+	if (list.textured) {
+		glVertexAttribPointer(color_texture_program.TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLbyte *)0 + tex_coord_offset);
+		gl_state.bind_texture(0, texture);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//----- draw -----
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, list.only_quads ? quad_indices : stream.buffer);
+	for (DrawList::Batch const &batch : list.batches) {
+		//the quad pattern is the same for every batch, so always starts at the beginning of quad_indices:
+		GLintptr offset = (list.only_quads ? 0 : index_offset + batch.first_index * sizeof(uint16_t));
+		glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(batch.index_count), GL_UNSIGNED_SHORT,
+			(GLbyte *)0 + offset, GLint(batch.base_vertex));
+	}
+
+	GL_ERRORS();
+}
+
+void DrawListRenderer::report(std::ostream &out, uint64_t frames) const {
+	if (frames == 0 || stats.lists == 0) return;
+	double uploaded = double(stats.vertex_bytes + stats.index_bytes);
+	out << "Draw lists: " << (stats.textured_lists / double(stats.lists) * 100.0) << "% textured; "
+		<< (uploaded / frames / 1024.0) << " KiB/frame uploaded ("
+		<< (stats.vertex_bytes / double(frames) / 1024.0) << " vertices + "
+		<< (stats.index_bytes / double(frames) / 1024.0) << " indices); unindexed 24-byte vertices would have been "
+		<< (stats.unindexed_bytes / double(frames) / 1024.0) << " KiB/frame ("
+		<< (100.0 * (1.0 - uploaded / double(stats.unindexed_bytes))) << "% saved)." << std::endl;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "DrawList.hpp"
+#include "ColorProgram.hpp"
+#include "ColorTextureProgram.hpp"
+#include "GL.hpp"
+
+#include <iosfwd>
+#include <memory>
+
+/*
+ * DrawListRenderer uploads DrawLists through VertexStream::shared and draws
+ *  them with glDrawElementsBaseVertex (one call per DrawList::Batch).
+ *
+ * Lists without texture coordinates (the usual case) are drawn with
+ *  ColorProgram, which fetches no texture; textured lists are drawn with
+ *  ColorTextureProgram, with the texture coordinates uploaded as a second stream.
+ *
+ * Lists made only of quads use a fixed index buffer of the repeating
+ *  {0,1,2, 0,2,3} pattern (built once), so only their vertices are uploaded;
+ *  other lists upload their 16-bit indices alongside their vertices.
+ */
+
+struct DrawListRenderer {
+	//(programs compile as part of 'batch', if given; don't draw until it is finished)
+	DrawListRenderer(GLProgramBatch *batch = nullptr);
+	~DrawListRenderer();
+
+	//upload and draw 'list' as triangles, transformed by 'object_to_clip':
+	// 'texture' is only used (bound to GL_TEXTURE0) if the list is textured.
+	// (blending, depth test, etc. are up to the caller)
+	void draw(DrawList const &list, glm::mat4 const &object_to_clip, GLuint texture = 0);
+
+	ColorProgram color_program;
+	ColorTextureProgram color_texture_program;
+
+	//Vertex Array Objects for each program (attributes are pointed at each list's data in draw()):
+	GLuint vertex_array_for_color_program = 0;
+	GLuint vertex_array_for_color_texture_program = 0;
+
+	//index buffer holding the quad pattern for DrawList::MaxBatchVertices vertices:
+	GLuint quad_indices = 0;
+
+	//----- statistics -----
+	struct Stats {
+		uint64_t lists = 0;
+		uint64_t textured_lists = 0;
+		uint64_t vertex_bytes = 0; //uploaded vertices (and texture coordinates)
+		uint64_t index_bytes = 0; //uploaded indices
+		uint64_t unindexed_bytes = 0; //what the same triangles would have uploaded as separate vertices in the old 24-byte position + color + texcoord layout
+	};
+	Stats stats;
+
+	//print a summary of 'stats' (averaged over 'frames'):
+	void report(std::ostream &out, uint64_t frames) const;
+
+	//the renderer shared by all modes:
+	// (main() creates it after the OpenGL context, and releases it before destroying the context)
+	static std::shared_ptr< DrawListRenderer > shared;
+};
@@ -0,0 +1,116 @@
+#include "FrameReadback.hpp"
+
+#include "gl_errors.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+FrameReadback::FrameReadback(uint32_t count) {
+	if (count == 0) throw std::runtime_error("FrameReadback needs at least one slot.");
+	slots.resize(count);
+	released.reset(new std::atomic< bool >[count]);
+	for (uint32_t i = 0; i < count; ++i) {
+		glGenBuffers(1, &slots[i].buffer);
+		released[i] = false;
+		free_slots.emplace_back(count - 1 - i);
+	}
+	GL_ERRORS();
+}
+
+FrameReadback::~FrameReadback() {
+	for (auto &slot : slots) {
+		if (slot.fence) glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		if (slot.mapped) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			slot.mapped = false;
+		}
+		glDeleteBuffers(1, &slot.buffer);
+		slot.buffer = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool FrameReadback::read(glm::uvec2 const &size, uint64_t tag) {
+	if (free_slots.empty() || size.x == 0 || size.y == 0) return false;
+	uint32_t index = free_slots.back();
+	free_slots.pop_back();
+	Slot &slot = slots[index];
+
+	slot.tag = tag;
+	slot.size = size;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	size_t bytes = size_t(size.x) * size.y * sizeof(glm::u8vec4);
+	if (bytes != slot.buffer_size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		slot.buffer_size = bytes;
+	}
+
+	//(with a pack buffer bound, glReadPixels writes to the buffer and returns without waiting)
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLbyte *)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	reading.emplace_back(index);
+
+	GL_ERRORS();
+	return true;
+}
+
+void FrameReadback::poll(std::function< void(Frame const &) > const &ready, bool wait) {
+	//unmap slots whose pixels are no longer needed:
+	for (uint32_t i = 0; i < slots.size(); ++i) {
+		if (!slots[i].mapped || !released[i]) continue;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		slots[i].mapped = false;
+		released[i] = false;
+		free_slots.emplace_back(i);
+	}
+
+	//map finished readbacks, oldest first:
+	while (!reading.empty()) {
+		uint32_t index = reading.front();
+		Slot &slot = slots[index];
+
+		GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (wait && result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)); //(1s, in ns)
+		}
+		if (result == GL_TIMEOUT_EXPIRED) break;
+		if (result == GL_WAIT_FAILED) {
+			std::cerr << "WARNING: FrameReadback fence wait failed." << std::endl;
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		reading.pop_front();
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.buffer_size, GL_MAP_READ_BIT);
+		if (!pixels) {
+			std::cerr << "WARNING: FrameReadback failed to map pixel buffer." << std::endl;
+			free_slots.emplace_back(index);
+			continue;
+		}
+		slot.mapped = true;
+
+		Frame frame;
+		frame.slot = index;
+		frame.tag = slot.tag;
+		frame.size = slot.size;
+		frame.pixels = reinterpret_cast< glm::u8vec4 const * >(pixels);
+		ready(frame);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	GL_ERRORS();
+}
+
+void FrameReadback::release(uint32_t slot) {
+	released[slot] = true;
+}
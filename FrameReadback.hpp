@@ -0,0 +1,66 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+ * FrameReadback copies the back buffer into pixel-pack buffers without stalling:
+ *  read() only queues the copy (glReadPixels into a GL_PIXEL_PACK_BUFFER) and a fence;
+ *  poll(), called once a frame, maps each buffer once its fence has passed --
+ *  normally a frame or two later -- and hands the pixels to a callback.
+ *
+ * The mapped pixels stay valid until release() is called for that slot, which
+ *  may happen on any thread (so a worker can read straight out of the mapping);
+ *  the next poll() then unmaps the buffer and makes the slot available again.
+ *
+ * Readbacks are delivered in the order they were read.
+ */
+
+struct FrameReadback {
+	FrameReadback(uint32_t slots);
+	~FrameReadback();
+
+	struct Frame {
+		uint32_t slot; //pass to release() when done with 'pixels'
+		uint64_t tag; //as given to read()
+		glm::uvec2 size;
+		glm::u8vec4 const *pixels; //RGBA, lower-left origin, rows tightly packed
+	};
+
+	//start copying the lower-left 'size' pixels of the back buffer;
+	// returns false (and does nothing) if every slot is busy or 'size' is empty:
+	bool read(glm::uvec2 const &size, uint64_t tag);
+
+	//unmap released slots, then map finished readbacks (oldest first) and pass them to 'ready';
+	// if 'wait' is set, waits for every outstanding readback:
+	void poll(std::function< void(Frame const &) > const &ready, bool wait = false);
+
+	//done with a Frame's pixels (thread-safe):
+	void release(uint32_t slot);
+
+	//readbacks read but not yet released:
+	uint32_t busy() const { return uint32_t(slots.size() - free_slots.size()); }
+
+	struct Slot {
+		GLuint buffer = 0;
+		size_t buffer_size = 0; //bytes allocated for 'buffer'
+		GLsync fence = nullptr; //set while reading
+		bool mapped = false;
+		uint64_t tag = 0;
+		glm::uvec2 size = glm::uvec2(0);
+	};
+	std::vector< Slot > slots;
+	std::vector< uint32_t > free_slots;
+	std::deque< uint32_t > reading; //slots with a fence, in read order
+
+	//set by release(), cleared when the slot is unmapped:
+	std::unique_ptr< std::atomic< bool >[] > released;
+};
@@ -0,0 +1,64 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+FrameStats::FrameStats(float refresh_rate_, float clamp_) : refresh_rate(refresh_rate_), clamp(clamp_) {
+	if (!(refresh_rate > 0.0f)) throw std::runtime_error("FrameStats needs a positive refresh rate.");
+	//about ten minutes at 60Hz before the first reallocation:
+	times.reserve(1 << 16);
+}
+
+void FrameStats::frame(float seconds) {
+	times.emplace_back(seconds);
+
+	if (seconds >= clamp) clamped += 1;
+
+	//refresh intervals this frame spanned (one is on time):
+	float intervals = seconds * refresh_rate;
+	if (intervals > 1.5f) {
+		missed += 1;
+		missed_refreshes += uint64_t(std::lround(intervals)) - 1;
+	}
+}
+
+void FrameStats::report(std::ostream &out) const {
+	out << "Frame times over " << times.size() << " frames:";
+	summarize(out, 0, times.size());
+	out << " Hit the " << (clamp * 1e3f) << " ms clamp " << clamped << " times;"
+		<< " missed vsync (" << refresh_rate << " Hz) on " << missed << " frames (" << missed_refreshes << " refreshes)." << std::endl;
+}
+
+void FrameStats::report_window(std::ostream &out) {
+	out << "Last " << (times.size() - window_start) << " frames:";
+	summarize(out, window_start, times.size());
+	out << std::endl;
+	window_start = times.size();
+}
+
+void FrameStats::summarize(std::ostream &out, size_t begin, size_t end) const {
+	if (begin >= end) {
+		out << " (none)";
+		return;
+	}
+	std::vector< float > sorted(times.begin() + begin, times.begin() + end);
+	std::sort(sorted.begin(), sorted.end());
+
+	//nearest-rank percentile:
+	auto percentile = [&sorted](float p) {
+		size_t rank = size_t(std::ceil(p / 100.0f * sorted.size()));
+		return sorted[std::min(sorted.size(), std::max< size_t >(rank, 1)) - 1];
+	};
+
+	double sum = 0.0;
+	for (float t : sorted) sum += t;
+
+	out << " mean " << (sum / sorted.size() * 1e3) << " ms;"
+		<< " p50 " << (percentile(50.0f) * 1e3f)
+		<< " p90 " << (percentile(90.0f) * 1e3f)
+		<< " p99 " << (percentile(99.0f) * 1e3f)
+		<< " p99.9 " << (percentile(99.9f) * 1e3f)
+		<< " worst " << (sorted.back() * 1e3f) << " ms.";
+}
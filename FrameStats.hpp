@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iosfwd>
+#include <vector>
+#include <cstdint>
+
+/*
+ * FrameStats collects the wall time of every frame (as main() measures it,
+ *  before the 0.1s clamp) and summarizes the distribution: percentiles, the
+ *  worst frame, frames that hit the clamp, and frames that missed vsync.
+ *
+ * A frame "misses vsync" when it took longer than 1.5 refresh intervals --
+ *  i.e., at least one refresh went by without a new frame; 'missed_refreshes'
+ *  counts how many refreshes were missed in total.
+ */
+
+struct FrameStats {
+	//'refresh_rate' is the display's rate in Hz; 'clamp' is main()'s elapsed time limit:
+	FrameStats(float refresh_rate = 60.0f, float clamp = 0.1f);
+
+	//record one frame's wall time (seconds):
+	void frame(float seconds);
+
+	//print a summary of all frames, or of the frames since the last report_window():
+	void report(std::ostream &out) const;
+	void report_window(std::ostream &out);
+
+	float refresh_rate;
+	float clamp;
+
+	std::vector< float > times; //every frame recorded, in order
+	size_t window_start = 0; //first frame of the current reporting window
+
+	//totals:
+	uint32_t clamped = 0; //frames at or over 'clamp'
+	uint32_t missed = 0; //frames that missed at least one refresh
+	uint64_t missed_refreshes = 0; //refreshes without a new frame
+
+private:
+	void summarize(std::ostream &out, size_t begin, size_t end) const;
+};
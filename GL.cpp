@@ -1,8 +1,11 @@
 #include "GL.hpp"
 
 #include <SDL.h>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <unordered_set>
 
 #ifdef _WIN32
 	#define DO(fn) \
@@ -14,6 +17,8 @@
 	#define DO(fn)
 #endif
 
+static void init_GL_extensions();
+
 void init_GL() {
 	DO(glDrawRangeElements)
 	DO(glTexImage3D)
@@ -298,6 +303,8 @@ void init_GL() {
 	DO(glVertexAttribP3uiv)
 	DO(glVertexAttribP4ui)
 	DO(glVertexAttribP4uiv)
+
+	init_GL_extensions();
 }
 #ifdef _WIN32
 	 void (APIENTRYFP glDrawRangeElements) (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices);
@@ -584,3 +591,129 @@ void init_GL() {
 	 void (APIENTRYFP glVertexAttribP4ui) (GLuint index, GLenum type, GLboolean normalized, GLuint value);
 	 void (APIENTRYFP glVertexAttribP4uiv) (GLuint index, GLenum type, GLboolean normalized, const GLuint *value);
 #endif
+
+//----- optional extensions -----
+
+GLCaps gl_caps;
+
+void (APIENTRY *ext_glBufferStorage) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) = nullptr;
+void (APIENTRY *ext_glGetProgramBinary) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) = nullptr;
+void (APIENTRY *ext_glProgramBinary) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) = nullptr;
+void (APIENTRY *ext_glProgramParameteri) (GLuint program, GLenum pname, GLint value) = nullptr;
+void (APIENTRY *ext_glDebugMessageControl) (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled) = nullptr;
+void (APIENTRY *ext_glDebugMessageInsert) (GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *buf) = nullptr;
+void (APIENTRY *ext_glDebugMessageCallback) (GLDEBUGPROC callback, const void *userParam) = nullptr;
+GLuint (APIENTRY *ext_glGetDebugMessageLog) (GLuint count, GLsizei bufSize, GLenum *sources, GLenum *types, GLuint *ids, GLenum *severities, GLsizei *lengths, GLchar *messageLog) = nullptr;
+void (APIENTRY *ext_glPushDebugGroup) (GLenum source, GLuint id, GLsizei length, const GLchar *message) = nullptr;
+void (APIENTRY *ext_glPopDebugGroup) (void) = nullptr;
+void (APIENTRY *ext_glObjectLabel) (GLenum identifier, GLuint name, GLsizei length, const GLchar *label) = nullptr;
+void (APIENTRY *ext_glGetObjectLabel) (GLenum identifier, GLuint name, GLsizei bufSize, GLsizei *length, GLchar *label) = nullptr;
+void (APIENTRY *ext_glObjectPtrLabel) (const void *ptr, GLsizei length, const GLchar *label) = nullptr;
+void (APIENTRY *ext_glGetObjectPtrLabel) (const void *ptr, GLsizei bufSize, GLsizei *length, GLchar *label) = nullptr;
+void (APIENTRY *ext_glMultiDrawArraysIndirect) (GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride) = nullptr;
+void (APIENTRY *ext_glMultiDrawElementsIndirect) (GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride) = nullptr;
+void (APIENTRY *ext_glMaxShaderCompilerThreadsKHR) (GLuint count) = nullptr;
+
+#define LOOKUP(fn, name) \
+	((ext_ ## fn = (decltype(ext_ ## fn))SDL_GL_GetProcAddress(name)) != nullptr)
+
+static void init_GL_extensions() {
+	gl_caps = GLCaps();
+	glGetIntegerv(GL_MAJOR_VERSION, &gl_caps.major);
+	glGetIntegerv(GL_MINOR_VERSION, &gl_caps.minor);
+	auto core = [](int major, int minor) {
+		return gl_caps.major > major || (gl_caps.major == major && gl_caps.minor >= minor);
+	};
+
+	std::unordered_set< std::string > extensions;
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+		if (name) extensions.insert(name);
+	}
+
+	//GL_DISABLE_EXTENSIONS lists gl_caps entries to treat as missing:
+	std::string disabled;
+	if (char const *env = std::getenv("GL_DISABLE_EXTENSIONS")) disabled = std::string(",") + env + ",";
+	auto has = [&extensions](char const *name) {
+		return extensions.count(name) != 0;
+	};
+	auto allowed = [&disabled](char const *cap) {
+		return disabled.find(std::string(",") + cap + ",") == std::string::npos;
+	};
+
+	//ARB_buffer_storage:
+	gl_caps.ARB_buffer_storage = allowed("ARB_buffer_storage")
+		&& (core(4, 4) || has("GL_ARB_buffer_storage"))
+		&& (LOOKUP(glBufferStorage, "glBufferStorage"));
+	if (!gl_caps.ARB_buffer_storage) {
+		ext_glBufferStorage = nullptr;
+	}
+
+	//ARB_get_program_binary:
+	gl_caps.ARB_get_program_binary = allowed("ARB_get_program_binary")
+		&& (core(4, 1) || has("GL_ARB_get_program_binary"))
+		&& (LOOKUP(glGetProgramBinary, "glGetProgramBinary"))
+		&& (LOOKUP(glProgramBinary, "glProgramBinary"))
+		&& (LOOKUP(glProgramParameteri, "glProgramParameteri"));
+	if (!gl_caps.ARB_get_program_binary) {
+		ext_glGetProgramBinary = nullptr;
+		ext_glProgramBinary = nullptr;
+		ext_glProgramParameteri = nullptr;
+	}
+
+	//KHR_debug:
+	gl_caps.KHR_debug = allowed("KHR_debug")
+		&& (core(4, 3) || has("GL_KHR_debug"))
+		&& (LOOKUP(glDebugMessageControl, "glDebugMessageControl"))
+		&& (LOOKUP(glDebugMessageInsert, "glDebugMessageInsert"))
+		&& (LOOKUP(glDebugMessageCallback, "glDebugMessageCallback"))
+		&& (LOOKUP(glGetDebugMessageLog, "glGetDebugMessageLog"))
+		&& (LOOKUP(glPushDebugGroup, "glPushDebugGroup"))
+		&& (LOOKUP(glPopDebugGroup, "glPopDebugGroup"))
+		&& (LOOKUP(glObjectLabel, "glObjectLabel"))
+		&& (LOOKUP(glGetObjectLabel, "glGetObjectLabel"))
+		&& (LOOKUP(glObjectPtrLabel, "glObjectPtrLabel"))
+		&& (LOOKUP(glGetObjectPtrLabel, "glGetObjectPtrLabel"));
+	if (!gl_caps.KHR_debug) {
+		ext_glDebugMessageControl = nullptr;
+		ext_glDebugMessageInsert = nullptr;
+		ext_glDebugMessageCallback = nullptr;
+		ext_glGetDebugMessageLog = nullptr;
+		ext_glPushDebugGroup = nullptr;
+		ext_glPopDebugGroup = nullptr;
+		ext_glObjectLabel = nullptr;
+		ext_glGetObjectLabel = nullptr;
+		ext_glObjectPtrLabel = nullptr;
+		ext_glGetObjectPtrLabel = nullptr;
+	}
+
+	//ARB_multi_draw_indirect:
+	gl_caps.ARB_multi_draw_indirect = allowed("ARB_multi_draw_indirect")
+		&& (core(4, 3) || has("GL_ARB_multi_draw_indirect"))
+		&& (LOOKUP(glMultiDrawArraysIndirect, "glMultiDrawArraysIndirect"))
+		&& (LOOKUP(glMultiDrawElementsIndirect, "glMultiDrawElementsIndirect"));
+	if (!gl_caps.ARB_multi_draw_indirect) {
+		ext_glMultiDrawArraysIndirect = nullptr;
+		ext_glMultiDrawElementsIndirect = nullptr;
+	}
+
+	//KHR_parallel_shader_compile:
+	gl_caps.KHR_parallel_shader_compile = allowed("KHR_parallel_shader_compile")
+		&& (has("GL_KHR_parallel_shader_compile") || has("GL_ARB_parallel_shader_compile"))
+		&& (LOOKUP(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsKHR") || LOOKUP(glMaxShaderCompilerThreadsKHR, "glMaxShaderCompilerThreadsARB"));
+	if (!gl_caps.KHR_parallel_shader_compile) {
+		ext_glMaxShaderCompilerThreadsKHR = nullptr;
+	}
+}
+
+void GLCaps::report(std::ostream &out) const {
+	out << "OpenGL " << major << "." << minor << ":";
+	out << " ARB_buffer_storage" << (ARB_buffer_storage ? " yes" : " no");
+	out << " ARB_get_program_binary" << (ARB_get_program_binary ? " yes" : " no");
+	out << " KHR_debug" << (KHR_debug ? " yes" : " no");
+	out << " ARB_multi_draw_indirect" << (ARB_multi_draw_indirect ? " yes" : " no");
+	out << " KHR_parallel_shader_compile" << (KHR_parallel_shader_compile ? " yes" : " no");
+	out << std::endl;
+}
@@ -13,10 +13,18 @@
  *
  * On MacOS, all are prototypes.
  *
+ * Optional extensions (see the end of this file) are function pointers on
+ *  every platform, looked up by init_GL() only if the context has the
+ *  extension; check gl_caps before using them, and fall back if absent.
+ *  (Setting GL_DISABLE_EXTENSIONS to, e.g., "KHR_debug,ARB_buffer_storage"
+ *  pretends those are missing, to test the fallbacks.)
+ *
  * This file has been automatically generated from glcorearb.h by make-GL.py
  *
  */
 
+#include <iosfwd>
+
 void init_GL(); //will throw on failure.
 
 extern "C" {
@@ -1276,4 +1284,116 @@ GLAPI void (APIENTRYFP glVertexAttribP3uiv) (GLuint index, GLenum type, GLboolea
 GLAPI void (APIENTRYFP glVertexAttribP4ui) (GLuint index, GLenum type, GLboolean normalized, GLuint value);
 GLAPI void (APIENTRYFP glVertexAttribP4uiv) (GLuint index, GLenum type, GLboolean normalized, const GLuint *value);
 
+// ----- optional extensions (only valid if gl_caps says so) -----
+
+// from GL_ARB_buffer_storage (core in 4.4):
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#define GL_DYNAMIC_STORAGE_BIT            0x0100
+#define GL_CLIENT_STORAGE_BIT             0x0200
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+#define GL_BUFFER_IMMUTABLE_STORAGE       0x821F
+#define GL_BUFFER_STORAGE_FLAGS           0x8220
+GLAPI void (APIENTRY *ext_glBufferStorage) (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+#define glBufferStorage ext_glBufferStorage
+
+// from GL_ARB_get_program_binary (core in 4.1):
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+#define GL_PROGRAM_BINARY_FORMATS         0x87FF
+GLAPI void (APIENTRY *ext_glGetProgramBinary) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+#define glGetProgramBinary ext_glGetProgramBinary
+GLAPI void (APIENTRY *ext_glProgramBinary) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+#define glProgramBinary ext_glProgramBinary
+GLAPI void (APIENTRY *ext_glProgramParameteri) (GLuint program, GLenum pname, GLint value);
+#define glProgramParameteri ext_glProgramParameteri
+
+// from GL_KHR_debug (core in 4.3):
+typedef void (APIENTRY  *GLDEBUGPROC)(GLenum source,GLenum type,GLuint id,GLenum severity,GLsizei length,const GLchar *message,const void *userParam);
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
+#define GL_DEBUG_NEXT_LOGGED_MESSAGE_LENGTH 0x8243
+#define GL_DEBUG_CALLBACK_FUNCTION        0x8244
+#define GL_DEBUG_CALLBACK_USER_PARAM      0x8245
+#define GL_DEBUG_SOURCE_API               0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM     0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER   0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY       0x8249
+#define GL_DEBUG_SOURCE_APPLICATION       0x824A
+#define GL_DEBUG_SOURCE_OTHER             0x824B
+#define GL_DEBUG_TYPE_ERROR               0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+#define GL_DEBUG_TYPE_PORTABILITY         0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE         0x8250
+#define GL_DEBUG_TYPE_OTHER               0x8251
+#define GL_DEBUG_LOGGED_MESSAGES          0x9145
+#define GL_DEBUG_SEVERITY_HIGH            0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM          0x9147
+#define GL_DEBUG_SEVERITY_LOW             0x9148
+#define GL_DEBUG_TYPE_MARKER              0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP          0x8269
+#define GL_DEBUG_TYPE_POP_GROUP           0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
+#define GL_DEBUG_GROUP_STACK_DEPTH        0x826D
+#define GL_DEBUG_OUTPUT                   0x92E0
+#define GL_MAX_DEBUG_MESSAGE_LENGTH       0x9143
+#define GL_MAX_DEBUG_LOGGED_MESSAGES      0x9144
+#define GL_MAX_DEBUG_GROUP_STACK_DEPTH    0x826C
+#define GL_MAX_LABEL_LENGTH               0x82E8
+#define GL_CONTEXT_FLAG_DEBUG_BIT         0x00000002
+#define GL_BUFFER                         0x82E0
+#define GL_SHADER                         0x82E1
+#define GL_PROGRAM                        0x82E2
+#define GL_QUERY                          0x82E3
+#define GL_PROGRAM_PIPELINE               0x82E4
+#define GL_SAMPLER                        0x82E6
+GLAPI void (APIENTRY *ext_glDebugMessageControl) (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled);
+#define glDebugMessageControl ext_glDebugMessageControl
+GLAPI void (APIENTRY *ext_glDebugMessageInsert) (GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *buf);
+#define glDebugMessageInsert ext_glDebugMessageInsert
+GLAPI void (APIENTRY *ext_glDebugMessageCallback) (GLDEBUGPROC callback, const void *userParam);
+#define glDebugMessageCallback ext_glDebugMessageCallback
+GLAPI GLuint (APIENTRY *ext_glGetDebugMessageLog) (GLuint count, GLsizei bufSize, GLenum *sources, GLenum *types, GLuint *ids, GLenum *severities, GLsizei *lengths, GLchar *messageLog);
+#define glGetDebugMessageLog ext_glGetDebugMessageLog
+GLAPI void (APIENTRY *ext_glPushDebugGroup) (GLenum source, GLuint id, GLsizei length, const GLchar *message);
+#define glPushDebugGroup ext_glPushDebugGroup
+GLAPI void (APIENTRY *ext_glPopDebugGroup) (void);
+#define glPopDebugGroup ext_glPopDebugGroup
+GLAPI void (APIENTRY *ext_glObjectLabel) (GLenum identifier, GLuint name, GLsizei length, const GLchar *label);
+#define glObjectLabel ext_glObjectLabel
+GLAPI void (APIENTRY *ext_glGetObjectLabel) (GLenum identifier, GLuint name, GLsizei bufSize, GLsizei *length, GLchar *label);
+#define glGetObjectLabel ext_glGetObjectLabel
+GLAPI void (APIENTRY *ext_glObjectPtrLabel) (const void *ptr, GLsizei length, const GLchar *label);
+#define glObjectPtrLabel ext_glObjectPtrLabel
+GLAPI void (APIENTRY *ext_glGetObjectPtrLabel) (const void *ptr, GLsizei bufSize, GLsizei *length, GLchar *label);
+#define glGetObjectPtrLabel ext_glGetObjectPtrLabel
+
+// from GL_ARB_multi_draw_indirect (core in 4.3):
+#define GL_DRAW_INDIRECT_BUFFER           0x8F3F
+#define GL_DRAW_INDIRECT_BUFFER_BINDING   0x8F43
+GLAPI void (APIENTRY *ext_glMultiDrawArraysIndirect) (GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride);
+#define glMultiDrawArraysIndirect ext_glMultiDrawArraysIndirect
+GLAPI void (APIENTRY *ext_glMultiDrawElementsIndirect) (GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+#define glMultiDrawElementsIndirect ext_glMultiDrawElementsIndirect
+
+// from GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile:
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+GLAPI void (APIENTRY *ext_glMaxShaderCompilerThreadsKHR) (GLuint count);
+#define glMaxShaderCompilerThreadsKHR ext_glMaxShaderCompilerThreadsKHR
+
 }
+
+//which optional extensions init_GL() found:
+struct GLCaps {
+	int major = 0, minor = 0; //context version
+	bool ARB_buffer_storage = false;
+	bool ARB_get_program_binary = false;
+	bool KHR_debug = false;
+	bool ARB_multi_draw_indirect = false;
+	bool KHR_parallel_shader_compile = false;
+
+	void report(std::ostream &out) const;
+};
+extern GLCaps gl_caps;
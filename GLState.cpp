@@ -0,0 +1,134 @@
+#include "GLState.hpp"
+
+#include <iostream>
+
+GLState gl_state;
+
+constexpr uint32_t GLState::TextureUnits;
+constexpr uint32_t GLState::Caps;
+constexpr GLuint GLState::Unknown;
+
+//index of a shadowed capability (or Caps if it isn't shadowed):
+static uint32_t cap_index(GLenum cap) {
+	switch (cap) {
+		case GL_BLEND: return 0;
+		case GL_DEPTH_TEST: return 1;
+		case GL_CULL_FACE: return 2;
+		case GL_SCISSOR_TEST: return 3;
+		default: return GLState::Caps;
+	}
+}
+
+void GLState::set_enabled(GLenum cap, bool enable) {
+	uint32_t i = cap_index(cap);
+	if (i < Caps && enabled[i] == int8_t(enable)) {
+		frame.skipped += 1;
+		return;
+	}
+	if (enable) glEnable(cap);
+	else glDisable(cap);
+	if (i < Caps) enabled[i] = int8_t(enable);
+	frame.issued += 1;
+}
+
+void GLState::enable(GLenum cap) {
+	set_enabled(cap, true);
+}
+
+void GLState::disable(GLenum cap) {
+	set_enabled(cap, false);
+}
+
+void GLState::blend_func(GLenum sfactor, GLenum dfactor) {
+	if (sfactor == blend_sfactor && dfactor == blend_dfactor) {
+		frame.skipped += 1;
+		return;
+	}
+	glBlendFunc(sfactor, dfactor);
+	blend_sfactor = sfactor;
+	blend_dfactor = dfactor;
+	frame.issued += 1;
+}
+
+void GLState::use_program(GLuint program_) {
+	if (program_ == program) {
+		frame.skipped += 1;
+		return;
+	}
+	glUseProgram(program_);
+	program = program_;
+	frame.issued += 1;
+}
+
+void GLState::bind_vertex_array(GLuint vertex_array_) {
+	if (vertex_array_ == vertex_array) {
+		frame.skipped += 1;
+		return;
+	}
+	glBindVertexArray(vertex_array_);
+	vertex_array = vertex_array_;
+	frame.issued += 1;
+}
+
+void GLState::bind_texture(uint32_t unit, GLuint texture) {
+	if (unit >= TextureUnits) {
+		//(not shadowed; leaves the active unit unknown)
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		active_texture = Unknown;
+		frame.issued += 1;
+		return;
+	}
+	if (textures[unit] == texture) {
+		frame.skipped += 1;
+		return;
+	}
+	if (active_texture != unit) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		active_texture = unit;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	textures[unit] = texture;
+	frame.issued += 1;
+}
+
+void GLState::deleted_program(GLuint program_) {
+	//(a program stays in use until something else is, so just stop trusting the shadow)
+	if (program_ != 0 && program == program_) program = Unknown;
+}
+
+void GLState::deleted_vertex_array(GLuint vertex_array_) {
+	//(deleting the bound vertex array binds zero)
+	if (vertex_array_ != 0 && vertex_array == vertex_array_) vertex_array = 0;
+}
+
+void GLState::deleted_texture(GLuint texture) {
+	//(deleting a bound texture binds zero in its place)
+	if (texture == 0) return;
+	for (auto &t : textures) {
+		if (t == texture) t = 0;
+	}
+}
+
+void GLState::invalidate() {
+	for (auto &e : enabled) e = -1;
+	blend_sfactor = blend_dfactor = Unknown;
+	program = Unknown;
+	vertex_array = Unknown;
+	active_texture = Unknown;
+	for (auto &t : textures) t = Unknown;
+}
+
+void GLState::end_frame() {
+	total.issued += frame.issued;
+	total.skipped += frame.skipped;
+	frames += 1;
+	frame = Counts();
+}
+
+void GLState::report(std::ostream &out) const {
+	if (frames == 0) return;
+	uint64_t changes = total.issued + total.skipped;
+	out << "GL state changes: " << double(total.issued) / frames << " issued, " << double(total.skipped) / frames << " skipped per frame"
+		<< " (" << (changes ? 100.0 * total.skipped / changes : 0.0) << "% redundant)." << std::endl;
+}
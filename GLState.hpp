@@ -0,0 +1,70 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <iosfwd>
+#include <cstdint>
+
+/*
+ * GLState shadows the bits of OpenGL state that every draw sets -- blending,
+ *  depth test, the current program, vertex array, and textures -- and skips
+ *  calls that wouldn't change anything. So draws just set what they need
+ *  (and don't reset it afterward); setting the same thing again is free.
+ *
+ * For the shadow to stay right, everything that changes this state has to
+ *  go through gl_state (or call invalidate() after changing it directly),
+ *  and deleting a program, vertex array, or texture must tell gl_state.
+ *
+ * The shadow starts out matching a new context's defaults.
+ */
+
+struct GLState {
+	//GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, and GL_SCISSOR_TEST are shadowed; others are passed through:
+	void enable(GLenum cap);
+	void disable(GLenum cap);
+	void blend_func(GLenum sfactor, GLenum dfactor);
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint vertex_array);
+	//bind a GL_TEXTURE_2D to texture unit GL_TEXTURE0 + 'unit':
+	void bind_texture(uint32_t unit, GLuint texture);
+
+	//call along with glDelete*, so a later object with the same name isn't mistaken for this one:
+	void deleted_program(GLuint program);
+	void deleted_vertex_array(GLuint vertex_array);
+	void deleted_texture(GLuint texture);
+
+	//forget everything (e.g., after changing state with direct OpenGL calls):
+	void invalidate();
+
+	//----- statistics -----
+	struct Counts {
+		uint64_t issued = 0; //state changes passed on to OpenGL
+		uint64_t skipped = 0; //state changes that matched the shadow
+	};
+	Counts frame; //so far this frame
+	Counts total; //over every finished frame
+	uint64_t frames = 0;
+
+	//call once per frame (after drawing) to add 'frame' to 'total' and start a new frame:
+	void end_frame();
+
+	//print per-frame averages:
+	void report(std::ostream &out) const;
+
+	static constexpr uint32_t TextureUnits = 8;
+	static constexpr uint32_t Caps = 4;
+
+private:
+	static constexpr GLuint Unknown = ~0U;
+	int8_t enabled[Caps] = {0, 0, 0, 0}; //-1 if unknown
+	GLenum blend_sfactor = GL_ONE, blend_dfactor = GL_ZERO;
+	GLuint program = 0;
+	GLuint vertex_array = 0;
+	uint32_t active_texture = 0;
+	GLuint textures[TextureUnits] = {0};
+
+	void set_enabled(GLenum cap, bool enable);
+};
+
+//(there's one OpenGL context, so one shadow)
+extern GLState gl_state;
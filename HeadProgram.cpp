@@ -0,0 +1,76 @@
+#include "HeadProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+HeadProgram::HeadProgram(GLProgramBatch *batch) {
+	GLProgramBatch now; //(finishes right here, if not given a batch)
+	program = (batch ? batch : &now)->add(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform vec2 HEAD_RADIUS;\n"
+		"uniform vec4 SKIN_COLORS[6];\n"
+		"uniform vec4 DEAD_COLOR;\n"
+		"in vec4 Position;\n"
+		"in vec4 Color;\n"
+		"in uint Kind;\n"
+		"in vec2 Center;\n"
+		"in vec2 Hair;\n"
+		"in float Happiness;\n"
+		"in uvec2 Look;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	bool dead = (Look.y != 0u);\n"
+		"	vec2 at = Position.xy;\n"
+		"	color = Color;\n"
+		"	if (Kind == 1u) {\n"
+		"		at.y = -HEAD_RADIUS.y - Hair.x;\n"
+		"	} else if (Kind == 2u) {\n"
+		"		at.y = -HEAD_RADIUS.y - Hair.x + HEAD_RADIUS.x * sin(Hair.y);\n"
+		"	} else if (Kind == 3u) {\n"
+		"		color = (dead ? DEAD_COLOR : SKIN_COLORS[min(Look.x, 5u)]);\n"
+		"	} else if (Kind == 4u) {\n"
+		"		at.y += Position.z * Happiness;\n"
+		"		if (dead) at = vec2(0.0);\n" //(collapsed triangles draw nothing)
+		"	} else if (Kind == 5u) {\n"
+		"		if (!dead) at = vec2(0.0);\n"
+		"	}\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(Center + at, 0.0, 1.0);\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	, [this](GLuint) {
+		//(runs once the program has linked)
+		//look up the locations of vertex attributes:
+		Position_vec4 = glGetAttribLocation(program, "Position");
+		Color_vec4 = glGetAttribLocation(program, "Color");
+		Kind_uint = glGetAttribLocation(program, "Kind");
+		Center_vec2 = glGetAttribLocation(program, "Center");
+		Hair_vec2 = glGetAttribLocation(program, "Hair");
+		Happiness_float = glGetAttribLocation(program, "Happiness");
+		Look_uvec2 = glGetAttribLocation(program, "Look");
+
+		//look up the locations of uniforms:
+		OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+		HEAD_RADIUS_vec2 = glGetUniformLocation(program, "HEAD_RADIUS");
+		SKIN_COLORS_vec4_array = glGetUniformLocation(program, "SKIN_COLORS");
+		DEAD_COLOR_vec4 = glGetUniformLocation(program, "DEAD_COLOR");
+
+		GL_ERRORS();
+	});
+	now.finish();
+}
+
+HeadProgram::~HeadProgram() {
+	gl_state.deleted_program(program);
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GL.hpp"
+
+struct GLProgramBatch;
+
+#include <cstdint>
+
+//Shader program that draws many heads from one retained head mesh, one instance per head:
+// the mesh is in head-local coordinates; each instance supplies where the head is and how it looks.
+struct HeadProgram {
+	//compiles right away, or (if given a batch) once the batch is finished:
+	HeadProgram(GLProgramBatch *batch = nullptr);
+	~HeadProgram();
+
+	GLuint program = 0;
+
+	//values for the per-vertex 'Kind' attribute:
+	enum Kind : uint8_t {
+		Fixed = 0, //drawn as-is, in its vertex color
+		HairLeft = 1, //bottom-left corner of the hair (moves with hair length)
+		HairRight = 2, //bottom-right corner of the hair (moves with hair length and cut angle)
+		Skin = 3, //colored by the instance's color index (or dead color)
+		Alive = 4, //only drawn on live heads; y moves by Position.z * happiness
+		Dead = 5, //only drawn on dead heads
+	};
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Position_vec4 = -1U; //xy: offset from head center; z: y offset per unit of happiness
+	GLuint Color_vec4 = -1U;
+	GLuint Kind_uint = -1U;
+
+	//Attribute (per-instance variable) locations:
+	GLuint Center_vec2 = -1U;
+	GLuint Hair_vec2 = -1U; //hair length, cut angle
+	GLuint Happiness_float = -1U;
+	GLuint Look_uvec2 = -1U; //color index, dead flag
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint HEAD_RADIUS_vec2 = -1U;
+	GLuint SKIN_COLORS_vec4_array = -1U; //[SkinColors]
+	GLuint DEAD_COLOR_vec4 = -1U;
+
+	static constexpr uint32_t SkinColors = 6;
+};
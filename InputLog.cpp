@@ -0,0 +1,105 @@
+#include "InputLog.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static char const Magic[8] = {'b','o','b','i','n','p','u','t'};
+static uint32_t const Version = 1;
+
+//bytes of the SDL_Event union worth storing for a given event type:
+static uint16_t payload_size(uint32_t type) {
+	switch (type) {
+		case SDL_MOUSEMOTION: return sizeof(SDL_MouseMotionEvent);
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP: return sizeof(SDL_MouseButtonEvent);
+		case SDL_MOUSEWHEEL: return sizeof(SDL_MouseWheelEvent);
+		case SDL_KEYDOWN:
+		case SDL_KEYUP: return sizeof(SDL_KeyboardEvent);
+		case SDL_WINDOWEVENT: return sizeof(SDL_WindowEvent);
+		default: return sizeof(SDL_CommonEvent);
+	}
+}
+
+template< typename T >
+static void write(std::ofstream &to, T const &val) {
+	to.write(reinterpret_cast< char const * >(&val), sizeof(T));
+}
+
+template< typename T >
+static bool read(std::ifstream &from, T *val) {
+	return bool(from.read(reinterpret_cast< char * >(val), sizeof(T)));
+}
+
+InputLogWriter::InputLogWriter(std::string const &filename, InputLogHeader const &header) : file(filename, std::ios::binary) {
+	if (!file) {
+		throw std::runtime_error("Failed to open input log '" + filename + "' for writing.");
+	}
+	file.write(Magic, sizeof(Magic));
+	write(file, Version);
+	write(file, header.seed);
+	write(file, header.tick_rate);
+	write(file, header.max_steps);
+}
+
+void InputLogWriter::event(SDL_Event const &evt, glm::uvec2 const &window_size) {
+	frame_events.emplace_back();
+	frame_events.back().evt = evt;
+	frame_events.back().window_size = window_size;
+}
+
+void InputLogWriter::end_frame(float elapsed) {
+	write(file, elapsed);
+	write(file, uint32_t(frame_events.size()));
+	for (auto const &e : frame_events) {
+		write(file, uint16_t(e.window_size.x));
+		write(file, uint16_t(e.window_size.y));
+		write(file, uint32_t(e.evt.type));
+		uint16_t size = payload_size(e.evt.type);
+		write(file, size);
+		file.write(reinterpret_cast< char const * >(&e.evt), size);
+	}
+	frame_events.clear();
+	++frames;
+	if (!file) {
+		throw std::runtime_error("Failed to write input log.");
+	}
+}
+
+InputLogReader::InputLogReader(std::string const &filename) : file(filename, std::ios::binary) {
+	if (!file) {
+		throw std::runtime_error("Failed to open input log '" + filename + "'.");
+	}
+	char magic[sizeof(Magic)];
+	uint32_t version = 0;
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0
+	 || !read(file, &version) || version != Version) {
+		throw std::runtime_error("'" + filename + "' is not a (current version) input log.");
+	}
+	if (!read(file, &header.seed) || !read(file, &header.tick_rate) || !read(file, &header.max_steps)) {
+		throw std::runtime_error("Input log '" + filename + "' has a truncated header.");
+	}
+}
+
+bool InputLogReader::next_frame() {
+	events.clear();
+	uint32_t count = 0;
+	if (!read(file, &elapsed) || !read(file, &count)) return false;
+	events.resize(count);
+	for (auto &e : events) {
+		uint16_t w = 0, h = 0;
+		uint32_t type = 0;
+		uint16_t size = 0;
+		if (!read(file, &w) || !read(file, &h) || !read(file, &type) || !read(file, &size)
+		 || size > sizeof(SDL_Event)) {
+			throw std::runtime_error("Input log is corrupt.");
+		}
+		std::memset(&e.evt, 0, sizeof(e.evt));
+		if (!file.read(reinterpret_cast< char * >(&e.evt), size)) {
+			throw std::runtime_error("Input log is truncated.");
+		}
+		e.evt.type = type;
+		e.window_size = glm::uvec2(w, h);
+	}
+	++frames;
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Input logs record what a session fed to its Mode -- every event passed to
+ *  Mode::handle_event and every frame's elapsed time -- so that the session
+ *  can be replayed exactly (and as fast as possible) later.
+ *
+ * File layout (little-endian, as written by the host):
+ *  header: "bobinput" magic, uint32 version, uint32 seed, float tick_rate, uint32 max_steps
+ *  then per frame: float elapsed, uint32 event count, and per event:
+ *   uint16 window width, uint16 window height, uint32 type, uint16 payload size, payload
+ *  (payload is only the part of the SDL_Event union that the event type uses)
+ */
+
+struct InputLogHeader {
+	uint32_t seed = 0; //seed for the Mode's random number generator
+	float tick_rate = 60.0f; //simulation rate the session ran at
+	uint32_t max_steps = 5; //catch-up limit the session ran with
+};
+
+struct InputLogEvent {
+	SDL_Event evt;
+	glm::uvec2 window_size;
+};
+
+//NOTE: both classes throw on error
+struct InputLogWriter {
+	InputLogWriter(std::string const &filename, InputLogHeader const &header);
+
+	//call for each event delivered to the mode, then once per frame with the elapsed time:
+	void event(SDL_Event const &evt, glm::uvec2 const &window_size);
+	void end_frame(float elapsed);
+
+	std::ofstream file;
+	std::vector< InputLogEvent > frame_events;
+	uint64_t frames = 0;
+};
+
+struct InputLogReader {
+	InputLogReader(std::string const &filename);
+
+	//read the next frame into 'events' and 'elapsed'; returns false at end of log:
+	bool next_frame();
+
+	std::ifstream file;
+	InputLogHeader header;
+	std::vector< InputLogEvent > events;
+	float elapsed = 0.0f;
+	uint64_t frames = 0;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+ * MappedFile maps a whole file read-only into memory (mmap on POSIX,
+ *  CreateFileMapping on Windows), so it can be parsed in place without
+ *  reading it through a stream into a separate buffer.
+ */
+
+//NOTE: throws on error
+struct MappedFile {
+	MappedFile(std::string const &filename);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	std::string filename;
+	void const *data = nullptr; //(nullptr for empty files)
+	size_t size = 0;
+
+#ifdef _WIN32
+	void *file = nullptr; //HANDLE
+	void *mapping = nullptr; //HANDLE
+#endif
+};
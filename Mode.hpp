@@ -13,12 +13,14 @@ struct Mode : std::enable_shared_from_this< Mode > {
 	//The function should return 'true' if it handled the event.
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) { return false; }
 
-	//update is called at the start of a new frame, after events are handled:
-	// 'elapsed' is time in seconds since the last call to 'update'
+	//update is called zero or more times per frame, after events are handled:
+	// the main loop runs it on a fixed timestep, so 'elapsed' is always the same (1 / tick rate)
 	virtual void update(float elapsed) { }
 
 	//draw is called after update:
-	virtual void draw(glm::uvec2 const &drawable_size) = 0;
+	// 'alpha' in [0,1) is how far the frame's time lies between the previous and the latest update,
+	// so modes can interpolate positions for smooth motion at any display rate
+	virtual void draw(glm::uvec2 const &drawable_size, float alpha) = 0;
 
 	//Mode::current is the Mode to which events are dispatched.
 	// use 'set_current' to change the current Mode (e.g., to switch to a menu)
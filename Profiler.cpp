@@ -0,0 +1,237 @@
+#include "Profiler.hpp"
+
+#include "DrawListRenderer.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+std::shared_ptr< Profiler > Profiler::shared;
+
+constexpr uint32_t Profiler::History;
+constexpr uint32_t Profiler::QueryFrames;
+
+char const *Profiler::phase_names[Profiler::PhaseCount] = {
+	"events",
+	"update",
+	"draw",
+	"swap",
+};
+
+char const *Profiler::pass_names[Profiler::PassCount] = {
+	"scene",
+	"overlay",
+};
+
+//overlay colors, by phase and by pass:
+static glm::u8vec4 const phase_colors[Profiler::PhaseCount] = {
+	glm::u8vec4(0x88, 0x88, 0xff, 0xff), //events
+	glm::u8vec4(0x44, 0xdd, 0x44, 0xff), //update
+	glm::u8vec4(0xff, 0xaa, 0x22, 0xff), //draw
+	glm::u8vec4(0x66, 0x66, 0x66, 0xff), //swap
+};
+static glm::u8vec4 const pass_colors[Profiler::PassCount] = {
+	glm::u8vec4(0xff, 0x44, 0x88, 0xff), //scene
+	glm::u8vec4(0xcc, 0x66, 0xff, 0xff), //overlay
+};
+
+Profiler::Profiler() {
+	cpu_total.fill(0.0);
+	gpu_total.fill(0.0);
+	cpu_worst.fill(0.0f);
+	gpu_worst.fill(0.0f);
+	phase_start.fill(Clock::now());
+
+	for (auto &p : pending) {
+		glGenQueries(PassCount, p.queries.data());
+		p.issued.fill(false);
+	}
+	history.reserve(History);
+
+	GL_ERRORS();
+}
+
+Profiler::~Profiler() {
+	for (auto &p : pending) {
+		glDeleteQueries(PassCount, p.queries.data());
+		p.queries.fill(0);
+	}
+}
+
+void Profiler::begin_frame() {
+	current = uint32_t(frame % QueryFrames);
+	PendingFrame &p = pending[current];
+
+	//this slot's queries are from QueryFrames frames ago, so are almost certainly done:
+	if (p.pending) finish(p);
+
+	p.times.frame = frame;
+	p.times.cpu.fill(0.0f);
+	p.times.gpu.fill(0.0f);
+	p.issued.fill(false);
+}
+
+void Profiler::end_frame() {
+	if (open_pass != -1) throw std::runtime_error("Profiler frame ended with GPU pass still open.");
+	pending[current].pending = true;
+	frame += 1;
+}
+
+void Profiler::begin(Phase phase) {
+	phase_start[phase] = Clock::now();
+}
+
+void Profiler::end(Phase phase) {
+	pending[current].times.cpu[phase] += std::chrono::duration< float >(Clock::now() - phase_start[phase]).count();
+}
+
+void Profiler::begin_gpu(Pass pass) {
+	if (open_pass != -1) throw std::runtime_error("Profiler GPU passes can't nest.");
+	PendingFrame &p = pending[current];
+	if (p.issued[pass]) throw std::runtime_error("Profiler GPU pass timed twice in one frame.");
+	glBeginQuery(GL_TIME_ELAPSED, p.queries[pass]);
+	p.issued[pass] = true;
+	open_pass = pass;
+}
+
+void Profiler::end_gpu() {
+	if (open_pass == -1) throw std::runtime_error("Profiler end_gpu() without begin_gpu().");
+	glEndQuery(GL_TIME_ELAPSED);
+	open_pass = -1;
+}
+
+void Profiler::finish(PendingFrame &p) {
+	for (uint32_t pass = 0; pass < PassCount; ++pass) {
+		if (!p.issued[pass]) continue;
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(p.queries[pass], GL_QUERY_RESULT, &ns);
+		p.times.gpu[pass] = float(ns * 1e-9);
+	}
+	p.pending = false;
+
+	FrameTimes const &t = p.times;
+	for (uint32_t i = 0; i < PhaseCount; ++i) {
+		cpu_total[i] += t.cpu[i];
+		cpu_worst[i] = std::max(cpu_worst[i], t.cpu[i]);
+	}
+	for (uint32_t i = 0; i < PassCount; ++i) {
+		gpu_total[i] += t.gpu[i];
+		gpu_worst[i] = std::max(gpu_worst[i], t.gpu[i]);
+	}
+	finished += 1;
+
+	if (history.size() < History) {
+		history.emplace_back(t);
+	} else {
+		history[history_next] = t;
+	}
+	history_next = (history_next + 1) % History;
+
+	if (csv.is_open()) {
+		csv << t.frame;
+		for (float s : t.cpu) csv << ',' << (s * 1e3f);
+		for (float s : t.gpu) csv << ',' << (s * 1e3f);
+		csv << '\n';
+	}
+}
+
+void Profiler::flush() {
+	//finish outstanding frames oldest-first, so history and CSV stay in order:
+	for (uint32_t i = 1; i <= QueryFrames; ++i) {
+		PendingFrame &p = pending[(current + i) % QueryFrames];
+		if (p.pending) finish(p);
+	}
+	if (csv.is_open()) csv.flush();
+}
+
+void Profiler::open_csv(std::string const &filename) {
+	csv.open(filename);
+	if (!csv) throw std::runtime_error("Failed to open '" + filename + "' for profile output.");
+	csv << "frame";
+	for (char const *name : phase_names) csv << ',' << name << "_ms";
+	for (char const *name : pass_names) csv << ",gpu_" << name << "_ms";
+	csv << '\n';
+}
+
+void Profiler::draw_overlay() {
+	if (!overlay) return;
+
+	//----- build graph (directly in clip space) -----
+	overlay_list.clear();
+	overlay_list.reserve(4 * (2 + 3 + History * (PhaseCount + PassCount)));
+
+	glm::vec2 const min = glm::vec2(-0.98f, 0.02f);
+	glm::vec2 const max = glm::vec2(-0.18f, 0.98f);
+	float const column = (max.x - min.x) / History;
+	float const split = 0.5f * (min.y + max.y);
+	float const budget = 1.0f / 60.0f;
+	//each graph is tall enough for two frames at 60Hz:
+	float const scale = (max.y - split - 0.02f) / (2.0f * budget);
+
+	auto box = [this](glm::vec2 const &a, glm::vec2 const &b, glm::u8vec4 const &color) {
+		overlay_list.rectangle(0.5f * (a + b), 0.5f * (b - a), color);
+	};
+
+	//background:
+	box(min, max, glm::u8vec4(0x00, 0x00, 0x00, 0xaa));
+
+	//one column per frame, oldest at the left:
+	uint32_t start = (history.size() < History ? 0 : history_next);
+	for (uint32_t i = 0; i < history.size(); ++i) {
+		FrameTimes const &t = history[(start + i) % History];
+		float x = min.x + i * column;
+
+		float y = split + 0.01f;
+		for (uint32_t p = 0; p < PhaseCount; ++p) {
+			float h = std::min(t.cpu[p] * scale, max.y - y);
+			if (h <= 0.0f) continue;
+			box(glm::vec2(x, y), glm::vec2(x + column, y + h), phase_colors[p]);
+			y += h;
+		}
+
+		y = min.y + 0.01f;
+		for (uint32_t p = 0; p < PassCount; ++p) {
+			float h = std::min(t.gpu[p] * scale, split - 0.01f - y);
+			if (h <= 0.0f) continue;
+			box(glm::vec2(x, y), glm::vec2(x + column, y + h), pass_colors[p]);
+			y += h;
+		}
+	}
+
+	//frame budget lines (one and two 60Hz frames), and the split between graphs:
+	glm::u8vec4 const line_color = glm::u8vec4(0xff, 0xff, 0xff, 0x66);
+	for (uint32_t n = 1; n <= 2; ++n) {
+		float y = n * budget * scale;
+		box(glm::vec2(min.x, split + 0.01f + y - 0.002f), glm::vec2(max.x, split + 0.01f + y + 0.002f), line_color);
+		box(glm::vec2(min.x, min.y + 0.01f + y - 0.002f), glm::vec2(max.x, min.y + 0.01f + y + 0.002f), line_color);
+	}
+	box(glm::vec2(min.x, split - 0.002f), glm::vec2(max.x, split + 0.002f), line_color);
+
+	//----- draw -----
+	begin_gpu(Overlay);
+
+	gl_state.disable(GL_DEPTH_TEST);
+	gl_state.enable(GL_BLEND);
+	glBlendEquation(GL_FUNC_ADD);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	DrawListRenderer::shared->draw(overlay_list, glm::mat4(1.0f));
+
+	end_gpu();
+
+	GL_ERRORS();
+}
+
+void Profiler::report(std::ostream &out) const {
+	if (finished == 0) return;
+	out << "Profile over " << finished << " frames (mean / worst ms):";
+	for (uint32_t i = 0; i < PhaseCount; ++i) {
+		out << " " << phase_names[i] << " " << (cpu_total[i] / finished * 1e3) << " / " << (cpu_worst[i] * 1e3f) << ";";
+	}
+	for (uint32_t i = 0; i < PassCount; ++i) {
+		out << " gpu " << pass_names[i] << " " << (gpu_total[i] / finished * 1e3) << " / " << (gpu_worst[i] * 1e3f) << (i + 1 < PassCount ? ";" : ".");
+	}
+	out << std::endl;
+}
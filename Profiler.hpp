@@ -0,0 +1,131 @@
+#pragma once
+
+#include "DrawList.hpp"
+#include "GL.hpp"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Profiler times each frame of the main loop:
+ *  - CPU time per phase (event poll, update, draw, swap) with high_resolution_clock;
+ *  - GPU time per pass with GL_TIME_ELAPSED queries.
+ *
+ * Query results are read 'QueryFrames' frames late (so reading them never stalls
+ *  the pipeline); a frame is "finished" -- added to the history, the overlay,
+ *  and the CSV file -- once its GPU times are in.
+ *
+ * The overlay (toggled with F3 in main()) is a graph of the most recent frames:
+ *  stacked CPU phase times on top, stacked GPU pass times below, with lines at
+ *  one and two 60Hz frames.
+ */
+
+struct Profiler {
+	enum Phase : uint8_t {
+		Events,
+		Update,
+		Draw,
+		Swap,
+		PhaseCount
+	};
+	static char const *phase_names[PhaseCount];
+
+	//GL_TIME_ELAPSED queries can't nest, so passes can't either:
+	enum Pass : uint8_t {
+		Scene, //Mode::current->draw()
+		Overlay, //the profiler's own graph
+		PassCount
+	};
+	static char const *pass_names[PassCount];
+
+	Profiler();
+	~Profiler();
+
+	//call at the start and end of each pass through the main loop:
+	void begin_frame();
+	void end_frame();
+
+	//CPU phase timing (a phase may be entered more than once per frame; times add up):
+	void begin(Phase phase);
+	void end(Phase phase);
+
+	//times a phase for the lifetime of the Scope:
+	struct Scope {
+		Scope(Profiler &profiler_, Phase phase_) : profiler(profiler_), phase(phase_) { profiler.begin(phase); }
+		~Scope() { profiler.end(phase); }
+		Profiler &profiler;
+		Phase phase;
+	};
+
+	//GPU pass timing (at most one pass may be open at a time):
+	void begin_gpu(Pass pass);
+	void end_gpu();
+
+	//draw the overlay graph (if 'overlay' is set) over whatever is in the framebuffer:
+	void draw_overlay();
+	bool overlay = false;
+
+	//write a line per finished frame (times in milliseconds) to 'filename':
+	void open_csv(std::string const &filename);
+
+	//wait for any outstanding queries so every frame so far is finished:
+	void flush();
+
+	//print mean and worst time per phase and pass:
+	void report(std::ostream &out) const;
+
+	//----- per-frame times -----
+	struct FrameTimes {
+		uint64_t frame = 0;
+		std::array< float, PhaseCount > cpu; //seconds
+		std::array< float, PassCount > gpu; //seconds (0 for passes that didn't run)
+	};
+
+	//most recent finished frames (ring buffer of 'History' entries, oldest at 'history_next' once full):
+	static constexpr uint32_t History = 240;
+	std::vector< FrameTimes > history;
+	uint32_t history_next = 0;
+
+	//totals over all finished frames:
+	uint64_t finished = 0;
+	std::array< double, PhaseCount > cpu_total;
+	std::array< double, PassCount > gpu_total;
+	std::array< float, PhaseCount > cpu_worst;
+	std::array< float, PassCount > gpu_worst;
+
+	//----- internals -----
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//frames in flight, each with one query per pass:
+	static constexpr uint32_t QueryFrames = 4;
+	struct PendingFrame {
+		FrameTimes times;
+		std::array< GLuint, PassCount > queries;
+		std::array< bool, PassCount > issued; //was the pass's query begun this frame?
+		bool pending = false;
+	};
+	std::array< PendingFrame, QueryFrames > pending;
+	uint32_t current = 0; //index into pending
+	uint64_t frame = 0; //number of the current frame
+
+	std::array< Clock::time_point, PhaseCount > phase_start;
+	int32_t open_pass = -1; //pass with an active query, or -1
+
+	std::ofstream csv;
+
+	//the overlay's shapes (kept between frames to reuse storage):
+	DrawList overlay_list;
+
+	//the profiler used by main():
+	// (main() creates it after the OpenGL context, and releases it before destroying the context)
+	static std::shared_ptr< Profiler > shared;
+
+private:
+	//read 'frame's query results (waiting if need be) and record its times:
+	void finish(PendingFrame &frame);
+};
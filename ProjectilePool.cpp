@@ -0,0 +1,68 @@
+#include "ProjectilePool.hpp"
+
+ProjectilePool::ProjectilePool(size_t capacity_) : capacity(capacity_) {
+	x.resize(capacity);
+	y.resize(capacity);
+	prev_x.resize(capacity);
+	prev_y.resize(capacity);
+	vx.resize(capacity);
+	vy.resize(capacity);
+	angle.resize(capacity);
+	prev_angle.resize(capacity);
+	spin.resize(capacity);
+	length.resize(capacity);
+}
+
+bool ProjectilePool::spawn(glm::vec2 const &position, glm::vec2 const &velocity, float angle_, float spin_, float length_) {
+	if (count == capacity) return false;
+	size_t i = count++;
+	x[i] = prev_x[i] = position.x;
+	y[i] = prev_y[i] = position.y;
+	vx[i] = velocity.x;
+	vy[i] = velocity.y;
+	angle[i] = prev_angle[i] = angle_;
+	spin[i] = spin_;
+	length[i] = length_;
+	return true;
+}
+
+//kept separate (with __restrict parameters) so the compiler can vectorize it:
+static void integrate_positions(
+	float *__restrict x, float *__restrict y, float *__restrict prev_x, float *__restrict prev_y,
+	float const *__restrict vx, float *__restrict vy, float *__restrict angle, float *__restrict prev_angle,
+	float const *__restrict spin, size_t count, float elapsed, float gravity) {
+	for (size_t i = 0; i < count; ++i) {
+		prev_x[i] = x[i];
+		prev_y[i] = y[i];
+		prev_angle[i] = angle[i];
+		vy[i] += elapsed * gravity;
+		x[i] += elapsed * vx[i];
+		y[i] += elapsed * vy[i];
+		angle[i] += elapsed * spin[i];
+	}
+}
+
+void ProjectilePool::integrate(float elapsed, float gravity) {
+	integrate_positions(x.data(), y.data(), prev_x.data(), prev_y.data(), vx.data(), vy.data(),
+		angle.data(), prev_angle.data(), spin.data(), count, elapsed, gravity);
+}
+
+size_t ProjectilePool::despawn_outside(glm::vec2 const &min, glm::vec2 const &max) {
+	return despawn_if([this, &min, &max](size_t p) {
+		return !(x[p] >= min.x && x[p] <= max.x && y[p] >= min.y && y[p] <= max.y);
+	});
+}
+
+void ProjectilePool::move_last_to(size_t p) {
+	size_t last = --count;
+	x[p] = x[last];
+	y[p] = y[last];
+	prev_x[p] = prev_x[last];
+	prev_y[p] = prev_y[last];
+	vx[p] = vx[last];
+	vy[p] = vy[last];
+	angle[p] = angle[last];
+	prev_angle[p] = prev_angle[last];
+	spin[p] = spin[last];
+	length[p] = length[last];
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * ProjectilePool stores up to a fixed number of in-flight projectiles
+ *  (e.g., thrown knives, falling strands of hair) as a structure of arrays.
+ *
+ * Live projectiles are always packed into indices [0, size()): spawning
+ *  appends, and despawning moves the last projectile into the hole.
+ * All storage is allocated up front, so spawning never touches the heap,
+ *  and integration is a straight vectorizable pass over the live range.
+ * (Indices are therefore not stable across despawn_outside() or despawn_if().)
+ */
+
+struct ProjectilePool {
+	ProjectilePool(size_t capacity = 0);
+
+	size_t size() const { return count; }
+	bool full() const { return count == capacity; }
+
+	//add a projectile; returns false (and does nothing) if the pool is full:
+	bool spawn(glm::vec2 const &position, glm::vec2 const &velocity, float angle, float spin = 0.0f, float length = 0.0f);
+
+	//move (and turn) every projectile for 'elapsed' seconds, accelerating downward by 'gravity'
+	// (remembering previous positions and angles for interpolation):
+	void integrate(float elapsed, float gravity = 0.0f);
+
+	//remove every projectile whose position is outside [min,max]; returns how many were removed:
+	size_t despawn_outside(glm::vec2 const &min, glm::vec2 const &max);
+
+	//remove every projectile i for which should_despawn(i) is true; returns how many were removed:
+	template< typename F >
+	size_t despawn_if(F const &should_despawn) {
+		size_t before = count;
+		//walk backward so that the projectile moved into a hole has already been checked:
+		for (size_t i = count; i > 0; --i) {
+			if (should_despawn(i - 1)) move_last_to(i - 1);
+		}
+		return before - count;
+	}
+
+	glm::vec2 position(size_t i) const { return glm::vec2(x[i], y[i]); }
+	glm::vec2 prev_position(size_t i) const { return glm::vec2(prev_x[i], prev_y[i]); }
+
+	size_t capacity = 0;
+	size_t count = 0;
+
+	std::vector< float > x, y; //position
+	std::vector< float > prev_x, prev_y; //position before the latest integrate() (for interpolation)
+	std::vector< float > vx, vy; //velocity
+	std::vector< float > angle, prev_angle; //heading (for drawing and hit testing)
+	std::vector< float > spin; //radians per second
+	std::vector< float > length; //extent along the heading (for whatever the owner needs it for)
+
+private:
+	//remove projectile i by moving the last projectile into its place:
+	void move_last_to(size_t i);
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+/*
+ * Rng is a small, fast, seedable pseudo-random number generator (PCG32;
+ *  see O'Neill, "PCG: A Family of Simple Fast Space-Efficient Statistically
+ *  Good Algorithms for Random Number Generation").
+ *
+ * Each simulation owns its own generators, so that runs are reproducible
+ *  from their seeds and independent simulations can run side-by-side.
+ * (It also satisfies UniformRandomBitGenerator, so works with <random> distributions.)
+ */
+
+struct Rng {
+	typedef uint32_t result_type;
+
+	//generators with the same seed and stream produce the same sequence;
+	// different streams with the same seed produce unrelated sequences:
+	explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+		inc = (stream << 1u) | 1u;
+		state = 0;
+		(*this)();
+		state += seed;
+		(*this)();
+	}
+
+	//uniform over all 32-bit values:
+	uint32_t operator()() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + inc;
+		uint32_t xorshifted = uint32_t(((old >> 18u) ^ old) >> 27u);
+		uint32_t rot = uint32_t(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+	}
+
+	//uniform in [0,1):
+	float unit() {
+		return ((*this)() >> 8) * (1.0f / float(1u << 24));
+	}
+
+	//uniform in [0,n) for n > 0 (Lemire's multiply-and-reject; unbiased):
+	uint32_t below(uint32_t n) {
+		uint64_t m = uint64_t((*this)()) * n;
+		uint32_t low = uint32_t(m);
+		if (low < n) {
+			uint32_t threshold = (0u - n) % n;
+			while (low < threshold) {
+				m = uint64_t((*this)()) * n;
+				low = uint32_t(m);
+			}
+		}
+		return uint32_t(m >> 32);
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits< result_type >::max(); }
+
+	uint64_t state;
+	uint64_t inc;
+};
@@ -0,0 +1,79 @@
+#include "Screenshots.hpp"
+
+#include "load_save_png.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+constexpr uint32_t Screenshots::Slots;
+
+Screenshots::Screenshots(std::string const &prefix_) : prefix(prefix_), readback(Slots) {
+	worker = std::thread(&Screenshots::work, this);
+}
+
+Screenshots::~Screenshots() {
+	//hand over every outstanding readback, then let the worker drain its queue:
+	readback.poll([this](FrameReadback::Frame const &frame){ enqueue(frame); }, true);
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+		wake.notify_one();
+	}
+	worker.join();
+	//(readback's destructor unmaps anything still mapped)
+}
+
+void Screenshots::take(glm::uvec2 const &size) {
+	if (!readback.read(size, 0)) {
+		std::cerr << "Skipping screenshot (" << readback.busy() << " still being saved)." << std::endl;
+	}
+}
+
+void Screenshots::update() {
+	if (readback.busy() == 0) return;
+	readback.poll([this](FrameReadback::Frame const &frame){ enqueue(frame); });
+}
+
+void Screenshots::enqueue(FrameReadback::Frame const &frame) {
+	std::unique_lock< std::mutex > lock(mutex);
+	queue.emplace_back(frame);
+	wake.notify_one();
+}
+
+void Screenshots::work() {
+	std::vector< glm::u8vec4 > pixels;
+	while (true) {
+		FrameReadback::Frame frame;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			wake.wait(lock, [this](){ return quit || !queue.empty(); });
+			if (queue.empty()) break; //(quit, and nothing left to do)
+			frame = queue.front();
+			queue.pop_front();
+		}
+
+		//copy out of the mapped buffer (forcing alpha to opaque) so the buffer can be released right away:
+		size_t count = size_t(frame.size.x) * frame.size.y;
+		pixels.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			pixels[i] = glm::u8vec4(frame.pixels[i].r, frame.pixels[i].g, frame.pixels[i].b, 0xff);
+		}
+		readback.release(frame.slot);
+
+		//first unused filename:
+		std::string filename;
+		do {
+			next_number += 1;
+			std::ostringstream name;
+			name << prefix << std::setw(4) << std::setfill('0') << next_number << ".png";
+			filename = name.str();
+		} while (std::ifstream(filename).good());
+
+		if (save_png(filename, frame.size, pixels.data(), LowerLeftOrigin)) {
+			std::cout << "Saved screenshot to '" << filename << "'." << std::endl;
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FrameReadback.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * Screenshots saves the back buffer to PNG files without stalling the frame:
+ *  take() queues a readback (see FrameReadback); update() hands finished
+ *  readbacks to a worker thread, which forces alpha to opaque, picks an
+ *  unused filename ('prefix' + number + ".png"), and encodes the PNG.
+ */
+
+struct Screenshots {
+	Screenshots(std::string const &prefix = "screenshot-");
+	//finishes any screenshots in progress:
+	~Screenshots();
+
+	//save the back buffer's lower-left 'size' pixels (call after drawing, before swapping):
+	void take(glm::uvec2 const &size);
+
+	//call once per frame:
+	void update();
+
+	std::string prefix;
+
+	//screenshots in progress may hold at most this many readbacks (further ones are skipped):
+	static constexpr uint32_t Slots = 2;
+	FrameReadback readback;
+
+	//----- worker -----
+	std::thread worker;
+	std::mutex mutex; //guards everything below
+	std::condition_variable wake;
+	std::deque< FrameReadback::Frame > queue; //mapped readbacks waiting to be encoded
+	bool quit = false;
+	uint32_t next_number = 0; //(only used by the worker)
+
+private:
+	void enqueue(FrameReadback::Frame const &frame);
+	void work();
+};
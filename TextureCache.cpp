@@ -0,0 +1,231 @@
+#include "TextureCache.hpp"
+
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace {
+	//entry file layout: Header, then 'path_bytes' of source path (padded to 4 bytes), then each level's pixels:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint64_t source_bytes;
+		int64_t source_mtime; //nanoseconds (or seconds, where the OS doesn't say) since the epoch
+		uint32_t width, height;
+		uint32_t levels;
+		uint32_t path_bytes;
+	};
+	static_assert(sizeof(Header) == 40, "TextureCache header should be packed");
+
+	constexpr char Magic[4] = {'t', 'x', 'c', '!'};
+	constexpr uint32_t Version = 1;
+
+	//size and modification time of a source file:
+	bool stat_source(std::string const &filename, uint64_t *bytes, int64_t *mtime) {
+		#ifdef _WIN32
+		struct _stat64 info;
+		if (_stat64(filename.c_str(), &info) != 0) return false;
+		*mtime = int64_t(info.st_mtime);
+		#else
+		struct stat info;
+		if (stat(filename.c_str(), &info) != 0) return false;
+		#if defined(__APPLE__)
+		*mtime = int64_t(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+		#else
+		*mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+		#endif
+		#endif
+		*bytes = uint64_t(info.st_size);
+		return true;
+	}
+
+	glm::uvec2 level_size(glm::uvec2 const &size, uint32_t level) {
+		return glm::uvec2(std::max(size.x >> level, 1U), std::max(size.y >> level, 1U));
+	}
+
+	uint32_t level_count(glm::uvec2 const &size, bool mipmaps) {
+		uint32_t levels = 1;
+		if (mipmaps) {
+			while (level_size(size, levels - 1) != glm::uvec2(1)) ++levels;
+		}
+		return levels;
+	}
+
+	size_t pixel_count(glm::uvec2 const &size, uint32_t levels) {
+		size_t count = 0;
+		for (uint32_t l = 0; l < levels; ++l) {
+			glm::uvec2 s = level_size(size, l);
+			count += size_t(s.x) * s.y;
+		}
+		return count;
+	}
+
+	uint32_t padded(uint32_t bytes) {
+		return (bytes + 3) & ~3U;
+	}
+}
+
+TextureCache::TextureCache(std::string const &directory_) : directory(directory_) {
+}
+
+std::string TextureCache::entry_filename(std::string const &filename, bool mipmaps) const {
+	//FNV-1a of the source path picks the entry; the header holds the full path to catch collisions:
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (char c : filename) {
+		hash = (hash ^ uint8_t(c)) * 0x100000001b3ULL;
+	}
+	std::ostringstream name;
+	name << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << hash << (mipmaps ? "-mip" : "") << ".rgba";
+	return name.str();
+}
+
+TextureCache::Image TextureCache::load(std::string const &filename, bool mipmaps) {
+	auto before = std::chrono::high_resolution_clock::now();
+	auto seconds_since = [](std::chrono::high_resolution_clock::time_point const &t) {
+		return std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - t).count();
+	};
+
+	uint64_t source_bytes = 0;
+	int64_t source_mtime = 0;
+	if (!stat_source(filename, &source_bytes, &source_mtime)) {
+		throw std::runtime_error("Failed to find texture '" + filename + "'.");
+	}
+	std::string entry = entry_filename(filename, mipmaps);
+
+	Image image;
+
+	//----- hit? -----
+	bool existed = false;
+	try {
+		std::unique_ptr< MappedFile > mapped(new MappedFile(entry));
+		existed = true;
+		Header const *header = reinterpret_cast< Header const * >(mapped->data);
+		char const *path = reinterpret_cast< char const * >(header + 1);
+		if (mapped->size >= sizeof(Header)
+		 && std::memcmp(header->magic, Magic, 4) == 0
+		 && header->version == Version
+		 && header->source_bytes == source_bytes
+		 && header->source_mtime == source_mtime
+		 && header->path_bytes == filename.size()
+		 && mapped->size >= sizeof(Header) + padded(header->path_bytes)
+		 && std::memcmp(path, filename.data(), filename.size()) == 0) {
+			image.size = glm::uvec2(header->width, header->height);
+			uint32_t levels = header->levels;
+			if (levels == level_count(image.size, mipmaps)
+			 && mapped->size == sizeof(Header) + padded(header->path_bytes) + pixel_count(image.size, levels) * sizeof(glm::u8vec4)) {
+				glm::u8vec4 const *pixels = reinterpret_cast< glm::u8vec4 const * >(path + padded(header->path_bytes));
+				for (uint32_t l = 0; l < levels; ++l) {
+					image.levels.emplace_back(pixels);
+					glm::uvec2 s = level_size(image.size, l);
+					pixels += size_t(s.x) * s.y;
+				}
+				image.mapped = std::move(mapped);
+				image.cached = true;
+				hits += 1;
+				hit_seconds += seconds_since(before);
+				return image;
+			}
+		}
+	} catch (std::runtime_error &) {
+		//(no entry yet)
+	}
+
+	//----- miss: decode, build mip levels, write the entry -----
+	misses += 1;
+	if (existed) stale += 1;
+
+	before = std::chrono::high_resolution_clock::now();
+	uint32_t levels = 0;
+	try {
+		//decode straight into the storage for all levels (level 0 first):
+		MappedFile png(filename);
+		image.size = png_size(png.data, png.size);
+		levels = level_count(image.size, mipmaps);
+		image.decoded.resize(pixel_count(image.size, levels));
+		load_png(png.data, png.size, image.decoded.data(), image.decoded.size(), LowerLeftOrigin);
+	} catch (std::runtime_error &) {
+		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
+	}
+	image.levels.emplace_back(image.decoded.data());
+	for (uint32_t l = 1; l < levels; ++l) {
+		//2x2 box filter (repeating the last row/column of odd-sized levels):
+		glm::uvec2 from_size = level_size(image.size, l - 1);
+		glm::uvec2 to_size = level_size(image.size, l);
+		glm::u8vec4 const *from = image.levels.back();
+		glm::u8vec4 *to = const_cast< glm::u8vec4 * >(from) + size_t(from_size.x) * from_size.y;
+		for (uint32_t y = 0; y < to_size.y; ++y) {
+			glm::u8vec4 const *row0 = from + size_t(std::min(2 * y, from_size.y - 1)) * from_size.x;
+			glm::u8vec4 const *row1 = from + size_t(std::min(2 * y + 1, from_size.y - 1)) * from_size.x;
+			for (uint32_t x = 0; x < to_size.x; ++x) {
+				uint32_t x0 = std::min(2 * x, from_size.x - 1);
+				uint32_t x1 = std::min(2 * x + 1, from_size.x - 1);
+				glm::uvec4 sum = glm::uvec4(row0[x0]) + glm::uvec4(row0[x1]) + glm::uvec4(row1[x0]) + glm::uvec4(row1[x1]);
+				to[size_t(y) * to_size.x + x] = glm::u8vec4((sum + glm::uvec4(2)) / 4U);
+			}
+		}
+		image.levels.emplace_back(to);
+	}
+	decode_seconds += seconds_since(before);
+
+	before = std::chrono::high_resolution_clock::now();
+	{
+		#ifdef _WIN32
+		_mkdir(directory.c_str());
+		#else
+		mkdir(directory.c_str(), 0755);
+		#endif
+
+		Header header;
+		std::memcpy(header.magic, Magic, 4);
+		header.version = Version;
+		header.source_bytes = source_bytes;
+		header.source_mtime = source_mtime;
+		header.width = image.size.x;
+		header.height = image.size.y;
+		header.levels = levels;
+		header.path_bytes = uint32_t(filename.size());
+		std::string path = filename;
+		path.resize(padded(header.path_bytes), '\0');
+
+		//write to a temporary file and rename it into place, so a partial entry is never seen:
+		std::string temporary = entry + ".tmp";
+		bool ok = false;
+		if (FILE *file = std::fopen(temporary.c_str(), "wb")) {
+			ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+			  && std::fwrite(path.data(), 1, path.size(), file) == path.size()
+			  && std::fwrite(image.decoded.data(), sizeof(glm::u8vec4), image.decoded.size(), file) == image.decoded.size();
+			ok = (std::fclose(file) == 0) && ok;
+			#ifdef _WIN32
+			if (ok) std::remove(entry.c_str()); //(rename won't replace a file on Windows)
+			#endif
+			ok = ok && std::rename(temporary.c_str(), entry.c_str()) == 0;
+			if (!ok) std::remove(temporary.c_str());
+		}
+		if (!ok && !write_failed) {
+			write_failed = true;
+			std::cerr << "WARNING: failed to write texture cache entry '" << entry << "'; textures will be decoded every time." << std::endl;
+		}
+	}
+	write_seconds += seconds_since(before);
+
+	return image;
+}
+
+void TextureCache::report(std::ostream &out) const {
+	out << "Texture cache '" << directory << "': "
+		<< hits << " hits (" << hit_seconds * 1e3 << " ms), "
+		<< misses << " misses" << (stale ? " (" + std::to_string(stale) + " stale)" : "")
+		<< " (" << decode_seconds * 1e3 << " ms decoding, " << write_seconds * 1e3 << " ms writing)." << std::endl;
+}
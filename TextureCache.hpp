@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * TextureCache keeps decoded images on disk, so that starting the game maps
+ *  ready-to-upload RGBA instead of running every PNG through libpng again.
+ *
+ * Each entry is one file in 'directory': a small header (the source's path,
+ *  size, and modification time, plus the image size and mip level count)
+ *  followed by the raw pixels of every level, already in OpenGL's
+ *  lower-left-origin row order. An entry whose source has changed is
+ *  simply decoded and written again.
+ *
+ * Usage:
+ *   TextureCache cache("texture-cache");
+ *   TextureCache::Image image = cache.load("knife.png", true); //with mipmaps
+ *   GLuint tex = gl_upload_texture(image);
+ *
+ * TextureCache does not touch OpenGL (see gl_upload_texture.hpp).
+ */
+
+struct TextureCache {
+	TextureCache(std::string const &directory);
+
+	struct Image {
+		glm::uvec2 size = glm::uvec2(0);
+		//level i is max(size >> i, 1) pixels, lower-left origin:
+		std::vector< glm::u8vec4 const * > levels;
+
+		bool cached = false; //true if this came from the cache (rather than being decoded)
+
+		//storage that 'levels' points into:
+		std::unique_ptr< MappedFile > mapped;
+		std::vector< glm::u8vec4 > decoded;
+	};
+
+	//load a PNG through the cache; 'mipmaps' also stores (box-filtered) mip levels down to 1x1.
+	//NOTE: throws if the PNG can't be loaded; failing to write the cache only prints a warning
+	Image load(std::string const &filename, bool mipmaps);
+
+	//the cache file used for a given source:
+	std::string entry_filename(std::string const &filename, bool mipmaps) const;
+
+	std::string directory;
+
+	//----- statistics -----
+	uint32_t hits = 0;
+	uint32_t misses = 0; //(includes stale entries)
+	uint32_t stale = 0; //entries that existed but no longer matched their source
+	double hit_seconds = 0.0; //checking and mapping entries
+	double decode_seconds = 0.0; //decoding (and building mip levels for) misses
+	double write_seconds = 0.0; //writing new entries
+	bool write_failed = false;
+
+	void report(std::ostream &out) const;
+};
@@ -0,0 +1,16 @@
+#include "UniformGrid.hpp"
+
+#include <cmath>
+
+void UniformGrid::reset(glm::vec2 const &min, glm::vec2 const &max, float cell_size) {
+	glm::vec2 size = max - min;
+	cells = glm::ivec2(
+		std::max(1, int(std::floor(size.x / cell_size))),
+		std::max(1, int(std::floor(size.y / cell_size)))
+	);
+	origin = min;
+	inv_cell_size = glm::vec2(cells.x / size.x, cells.y / size.y);
+
+	cell_start.assign(size_t(cells.x) * size_t(cells.y) + 1, 0);
+	items.clear();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+/*
+ * UniformGrid buckets points (given by index) into equal-sized cells over a
+ *  rectangle, so that "what is near here?" queries only look at nearby cells.
+ *
+ * It is rebuilt from scratch with a counting sort whenever the points move,
+ *  which keeps items in each cell contiguous in memory.
+ * Points outside the rectangle are clamped into the border cells.
+ */
+
+struct UniformGrid {
+	//cover [min,max] with cells that are (at least) cell_size on a side:
+	void reset(glm::vec2 const &min, glm::vec2 const &max, float cell_size);
+
+	//rebuild from 'count' points, keeping only those for which include(i) is true:
+	template< typename Include >
+	void build(float const *x, float const *y, size_t count, Include const &include);
+
+	//call visit(i) for every point in a cell that overlaps the box [lo,hi]:
+	// (the caller still needs to do its own exact test)
+	template< typename Visit >
+	void query(glm::vec2 const &lo, glm::vec2 const &hi, Visit const &visit) const;
+
+	//which cell a position falls into:
+	glm::ivec2 cell_of(float x, float y) const {
+		return glm::ivec2(
+			std::min(std::max(int((x - origin.x) * inv_cell_size.x), 0), cells.x - 1),
+			std::min(std::max(int((y - origin.y) * inv_cell_size.y), 0), cells.y - 1)
+		);
+	}
+
+	glm::vec2 origin = glm::vec2(0.0f);
+	glm::vec2 inv_cell_size = glm::vec2(1.0f);
+	glm::ivec2 cells = glm::ivec2(1, 1);
+
+	//items in cell c are items[cell_start[c]] .. items[cell_start[c+1]-1]:
+	std::vector< uint32_t > cell_start;
+	std::vector< uint32_t > items;
+
+	//scratch space for build(), kept around to avoid reallocating:
+	std::vector< uint32_t > item_cell;
+};
+
+template< typename Include >
+void UniformGrid::build(float const *x, float const *y, size_t count, Include const &include) {
+	std::fill(cell_start.begin(), cell_start.end(), 0);
+	item_cell.resize(count);
+
+	//count items per cell (stored shifted by one so a prefix sum gives start offsets):
+	uint32_t const Excluded = uint32_t(-1);
+	for (size_t i = 0; i < count; ++i) {
+		if (!include(i)) {
+			item_cell[i] = Excluded;
+			continue;
+		}
+		glm::ivec2 c = cell_of(x[i], y[i]);
+		item_cell[i] = uint32_t(c.y * cells.x + c.x);
+		cell_start[item_cell[i] + 1] += 1;
+	}
+	for (size_t c = 1; c < cell_start.size(); ++c) {
+		cell_start[c] += cell_start[c-1];
+	}
+
+	//scatter items into their cells (using cell_start[c] as a cursor, then shifting back):
+	items.resize(cell_start.back());
+	for (size_t i = 0; i < count; ++i) {
+		if (item_cell[i] == Excluded) continue;
+		items[cell_start[item_cell[i]]++] = uint32_t(i);
+	}
+	for (size_t c = cell_start.size() - 1; c > 0; --c) {
+		cell_start[c] = cell_start[c-1];
+	}
+	cell_start[0] = 0;
+}
+
+template< typename Visit >
+void UniformGrid::query(glm::vec2 const &lo, glm::vec2 const &hi, Visit const &visit) const {
+	glm::ivec2 min = cell_of(lo.x, lo.y);
+	glm::ivec2 max = cell_of(hi.x, hi.y);
+	for (int cy = min.y; cy <= max.y; ++cy) {
+		for (int cx = min.x; cx <= max.x; ++cx) {
+			uint32_t c = uint32_t(cy * cells.x + cx);
+			for (uint32_t i = cell_start[c]; i < cell_start[c+1]; ++i) {
+				visit(items[i]);
+			}
+		}
+	}
+}
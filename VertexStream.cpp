@@ -0,0 +1,134 @@
+#include "VertexStream.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+std::shared_ptr< VertexStream > VertexStream::shared;
+
+VertexStream::VertexStream(size_t frame_size_, uint32_t frames_) : frame_size(frame_size_), frames(frames_) {
+	if (frame_size == 0 || frames == 0) throw std::runtime_error("VertexStream needs a non-zero frame size and frame count.");
+	fences.assign(frames, nullptr);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, frame_size * frames, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GL_ERRORS();
+}
+
+VertexStream::~VertexStream() {
+	for (auto &fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+void VertexStream::begin_frame() {
+	frame_bytes = 0;
+	frame_stall = 0.0;
+	offset = 0;
+
+	GLsync &fence = fences[frame];
+	if (!fence) return;
+
+	//usually the GPU finished with this region long ago, so check without waiting first:
+	GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		auto before = std::chrono::high_resolution_clock::now();
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000)); //(1s, in ns)
+		} while (result == GL_TIMEOUT_EXPIRED);
+		frame_stall = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+		stats.stall += frame_stall;
+		stats.max_stall = std::max(stats.max_stall, frame_stall);
+		stats.stalls += 1;
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "WARNING: VertexStream fence wait failed." << std::endl;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void VertexStream::end_frame() {
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % frames;
+
+	stats.frames += 1;
+	stats.bytes += frame_bytes;
+	stats.max_bytes = std::max< uint64_t >(stats.max_bytes, frame_bytes);
+}
+
+GLintptr VertexStream::upload(void const *data, size_t size, size_t alignment) {
+	if (size == 0) return 0;
+
+	//align the offset within the whole buffer (frame_size needn't be a multiple of 'alignment'):
+	auto aligned_start = [&]() {
+		size_t base = frame * frame_size;
+		return (base + offset + alignment - 1) / alignment * alignment - base;
+	};
+	size_t start = aligned_start();
+	if (start + size > frame_size) {
+		grow(size + alignment);
+		start = aligned_start();
+	}
+
+	GLintptr at = GLintptr(frame * frame_size + start);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	void *dst = glMapBufferRange(GL_ARRAY_BUFFER, at, GLsizeiptr(size),
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (!dst) {
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		throw std::runtime_error("VertexStream failed to map buffer range.");
+	}
+	std::memcpy(dst, data, size);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	offset = start + size;
+	frame_bytes += size;
+	return at;
+}
+
+void VertexStream::reserve(size_t size) {
+	if (offset + size > frame_size) grow(size);
+}
+
+void VertexStream::grow(size_t needed) {
+	while (frame_size < needed) frame_size *= 2;
+	frame_size *= 2;
+
+	//fresh storage (draws already issued keep reading the old storage), so no region is in use:
+	for (auto &fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, frame_size * frames, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	offset = 0;
+	stats.grows += 1;
+
+	GL_ERRORS();
+}
+
+void VertexStream::report(std::ostream &out) const {
+	if (stats.frames == 0) return;
+	out << "Vertex stream: " << stats.frames << " frames, "
+		<< (stats.bytes / double(stats.frames) / 1024.0) << " KiB/frame uploaded on average (max "
+		<< (stats.max_bytes / 1024.0) << " KiB); "
+		<< stats.stalls << " frames waited on the GPU, "
+		<< (stats.stall * 1000.0 / stats.frames) << " ms/frame on average (max "
+		<< (stats.max_stall * 1000.0) << " ms)";
+	if (stats.grows) out << "; grew " << stats.grows << " times (now " << (frame_size * frames / 1024) << " KiB)";
+	out << "." << std::endl;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <iosfwd>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+ * VertexStream hands out space for per-frame vertex data in one large buffer,
+ *  instead of having each mode re-specify its own buffer with glBufferData every frame.
+ *
+ * The buffer is split into 'frames' regions, used round-robin. Data is written
+ *  with glMapBufferRange(UNSYNCHRONIZED | INVALIDATE_RANGE), so the driver never
+ *  waits on (or copies around) storage the GPU may still be reading; instead, each
+ *  region is guarded by a fence, and begin_frame() waits only if the GPU is still
+ *  using the region from 'frames' frames ago.
+ *
+ * If a frame needs more space than a region holds, the buffer is reallocated
+ *  (twice as large) and that frame carries on in the new storage.
+ */
+
+struct VertexStream {
+	VertexStream(size_t frame_size = size_t(4) << 20, uint32_t frames = 3);
+	~VertexStream();
+
+	//call once per frame before any upload() (waits, if needed, for the GPU to release this frame's region):
+	void begin_frame();
+	//call once per frame after the last draw that reads this frame's data:
+	void end_frame();
+
+	//copy 'size' bytes into this frame's region, at a byte offset within 'buffer' that is a multiple of 'alignment';
+	// returns that offset:
+	GLintptr upload(void const *data, size_t size, size_t alignment);
+
+	//make sure the next uploads (up to 'size' bytes, alignment padding included) fit in this frame's region,
+	// growing the buffer now if they wouldn't:
+	//(a draw that makes several uploads should reserve them all first -- growing orphans the storage
+	// holding any earlier uploads, so growing partway through would leave the draw reading garbage)
+	void reserve(size_t size);
+
+	//the buffer (bind this as the GL_ARRAY_BUFFER when setting up vertex array objects):
+	GLuint buffer = 0;
+
+	size_t frame_size; //bytes per region
+	uint32_t frames; //number of regions
+
+	//current region and write position within it:
+	uint32_t frame = 0;
+	size_t offset = 0;
+	std::vector< GLsync > fences; //per region; set by end_frame(), cleared by begin_frame()
+
+	//----- statistics -----
+	struct Stats {
+		uint64_t frames = 0;
+		uint64_t bytes = 0; //total uploaded
+		uint64_t max_bytes = 0; //most uploaded in one frame
+		double stall = 0.0; //total seconds spent waiting on fences
+		double max_stall = 0.0; //longest wait in one frame
+		uint32_t stalls = 0; //frames that had to wait at all
+		uint32_t grows = 0; //times the buffer was reallocated
+	};
+	Stats stats;
+	size_t frame_bytes = 0; //uploaded so far this frame
+	double frame_stall = 0.0; //waited this frame
+
+	//print a one-paragraph summary of 'stats':
+	void report(std::ostream &out) const;
+
+	//the stream shared by all modes:
+	// (main() creates it after the OpenGL context, and releases it before destroying the context)
+	static std::shared_ptr< VertexStream > shared;
+
+private:
+	void grow(size_t needed);
+};
@@ -0,0 +1,146 @@
+//bob_sim runs BobSim headless with scripted input and reports how fast it ticks.
+// usage: bob_sim [--ticks N] [--tick-rate HZ] [--seed S] [--heads N] [--lives N] [--fire single|rapid|spread] [--knives N] [--hairs N]
+// e.g., per-head update cost in a stress crowd: bob_sim --heads 100000 --lives 1000000000 --ticks 10000
+// e.g., knife integration + collision cost: bob_sim --knives 1000 --heads 1000 --lives 1000000000 --ticks 100000
+//  (--knives N keeps N knives in flight, thrown from random spots along the left wall;
+//   ns/knife/tick includes the head update, so compare against a run without --knives)
+// e.g., falling hair cost: bob_sim --hairs 50000 --lives 1000000000 --ticks 10000
+//  (--hairs N keeps N severed strands falling; 50k strands should cost well under 1 ms per tick)
+// e.g., lost games restart in a big crowd: bob_sim --heads 1000 --ticks 100000
+//  (every run also checks that lives never go up during a game, and fails if they do)
+
+#include "BobSim.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv) {
+	uint64_t ticks = 10000000;
+	float tick_rate = 60.0f;
+	uint32_t seed = 0;
+	uint32_t heads = 4;
+	uint32_t lives = 3;
+	BobSim::FireMode fire = BobSim::FireMode::Single;
+	uint32_t knives = 0;
+	uint32_t hairs = 0;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--ticks" && argi + 1 < argc) {
+			ticks = std::strtoull(argv[++argi], nullptr, 10);
+		} else if (arg == "--tick-rate" && argi + 1 < argc) {
+			tick_rate = std::stof(argv[++argi]);
+		} else if (arg == "--seed" && argi + 1 < argc) {
+			seed = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--heads" && argi + 1 < argc) {
+			heads = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--lives" && argi + 1 < argc) {
+			lives = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--fire" && argi + 1 < argc) {
+			std::string mode = argv[++argi];
+			if (mode == "single") fire = BobSim::FireMode::Single;
+			else if (mode == "rapid") fire = BobSim::FireMode::Rapid;
+			else if (mode == "spread") fire = BobSim::FireMode::Spread;
+			else {
+				std::cerr << "Unknown fire mode '" << mode << "' (expecting single, rapid, or spread)." << std::endl;
+				return 1;
+			}
+		} else if (arg == "--knives" && argi + 1 < argc) {
+			knives = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--hairs" && argi + 1 < argc) {
+			hairs = uint32_t(std::stoul(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--ticks N] [--tick-rate HZ] [--seed S] [--heads N] [--lives N] [--fire single|rapid|spread] [--knives N] [--hairs N]" << std::endl;
+			return 1;
+		}
+	}
+
+	float const elapsed = 1.0f / tick_rate;
+
+	BobSim sim(seed, heads);
+	uint64_t games = 1;
+	uint64_t total_score = 0;
+	uint64_t knife_ticks = 0; //sum over ticks of knives in flight
+	uint64_t hair_ticks = 0; //sum over ticks of falling strands
+	uint32_t knife_seed = 1;
+
+	//(re)configure a freshly-started game:
+	auto setup = [&]() {
+		sim.lives = lives;
+		if (knives > sim.knives.capacity) sim.knives = ProjectilePool(knives);
+		if (hairs > sim.hairs.capacity) sim.hairs = ProjectilePool(hairs);
+		sim.set_fire_mode(fire);
+	};
+	setup();
+
+	auto before = std::chrono::high_resolution_clock::now();
+	for (uint64_t tick = 0; tick < ticks; ++tick) {
+		//scripted player: sweep aim up and down the court and throw whenever the knife is in hand:
+		float t = tick * elapsed;
+		sim.aim(glm::vec2(0.5f * sim.court_radius.x, sim.court_radius.y * std::sin(1.3f * t)));
+		if (fire == BobSim::FireMode::Rapid) {
+			sim.press_trigger();
+		} else if (sim.knives.size() == 0) {
+			sim.press_trigger();
+			sim.release_trigger();
+		}
+
+		//top up the stress-test knives:
+		// (positions come from a cheap LCG, so as not to disturb the game's own random numbers)
+		while (sim.knives.size() < knives) {
+			knife_seed = knife_seed * 1664525u + 1013904223u;
+			float y = sim.court_radius.y * ((knife_seed >> 8) / float(1 << 24) * 2.0f - 1.0f);
+			float angle = ((knife_seed & 0xff) / 255.0f - 0.5f);
+			sim.throw_knife(glm::vec2(-sim.court_radius.x, y), angle);
+		}
+
+		//top up the stress-test hair, dropping strands in from across the top of the court:
+		while (sim.hairs.size() < hairs) {
+			knife_seed = knife_seed * 1664525u + 1013904223u;
+			float x = sim.court_radius.x * ((knife_seed >> 8) / float(1 << 24) * 2.0f - 1.0f);
+			float spin = ((knife_seed & 0xff) / 255.0f - 0.5f) * 6.0f;
+			sim.hairs.spawn(glm::vec2(x, sim.court_radius.y), glm::vec2(0.0f, 0.0f), 0.0f, spin, 1.0f);
+		}
+
+		uint32_t lives_before = sim.lives;
+		sim.update(elapsed);
+		if (sim.lives > lives_before) {
+			std::cerr << "ERROR: lives went from " << lives_before << " to " << sim.lives << " at tick " << tick << " of game " << games << "." << std::endl;
+			return 1;
+		}
+		knife_ticks += sim.knives.size();
+		hair_ticks += sim.hairs.size();
+
+		//start a new game once this one is lost, so the benchmark measures live play:
+		if (sim.lives == 0) {
+			total_score += sim.score;
+			sim = BobSim(seed + uint32_t(games), heads);
+			setup();
+			++games;
+		}
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	total_score += sim.score;
+
+	double seconds = std::chrono::duration< double >(after - before).count();
+	std::cout << "bob_sim: " << ticks << " ticks (" << (ticks / tick_rate) << " simulated seconds) in " << seconds << " s" << std::endl;
+	std::cout << "  " << (ticks / seconds) << " ticks/second" << std::endl;
+	std::cout << "  " << (seconds * 1e9 / ticks) << " ns/tick" << std::endl;
+	std::cout << "  " << (seconds * 1e9 / ticks / heads) << " ns/head/tick (" << heads << " heads, " << sim.num_visible << " visible at end)" << std::endl;
+	if (knife_ticks) {
+		std::cout << "  " << (seconds * 1e9 / knife_ticks) << " ns/knife/tick (" << (double(knife_ticks) / ticks) << " knives in flight on average)" << std::endl;
+	}
+	if (hairs) {
+		double hairs_per_tick = double(hair_ticks) / ticks;
+		double ns_per_hair = seconds * 1e9 / hair_ticks;
+		std::cout << "  " << ns_per_hair << " ns/hair/tick (" << hairs_per_tick << " strands falling on average; "
+			<< (ns_per_hair * 50000.0 * 1e-6) << " ms/tick at 50k)" << std::endl;
+	}
+	std::cout << "  " << games << " games, " << total_score << " total score" << std::endl;
+
+	return 0;
+}
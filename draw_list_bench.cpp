@@ -0,0 +1,120 @@
+//draw_list_bench measures how fast DrawList emits primitives (no window or OpenGL needed).
+// usage: draw_list_bench [--frames N] [--prims N]
+// each "frame" clears the list and emits --prims primitives of one kind; results are in primitives per second,
+// along with the bytes per primitive DrawListRenderer would upload (vs. unindexed triangles of the old 24-byte vertices).
+
+#include "DrawList.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+//the vertex layout draw lists used before DrawList::Vertex dropped texture coordinates:
+struct OldVertex {
+	OldVertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+		Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+	glm::vec3 Position;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+
+int main(int argc, char **argv) {
+	uint32_t frames = 1000;
+	uint32_t prims = 10000;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--frames" && argi + 1 < argc) {
+			frames = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--prims" && argi + 1 < argc) {
+			prims = uint32_t(std::stoul(argv[++argi]));
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--frames N] [--prims N]" << std::endl;
+			return 1;
+		}
+	}
+
+	glm::u8vec4 const color = glm::u8vec4(0xff, 0x88, 0x00, 0xff);
+	//primitive positions (scattered so that nothing gets constant-folded):
+	std::vector< glm::vec2 > centers(prims);
+	for (uint32_t i = 0; i < prims; ++i) {
+		centers[i] = glm::vec2(float(i % 97) * 0.1f, float(i % 89) * 0.1f);
+	}
+
+	DrawList list;
+	size_t checksum = 0; //(keeps the compiler from discarding the work)
+
+	auto bench = [&](char const *name, std::function< void(uint32_t) > const &emit) {
+		//one untimed frame to size the list, as a running game would have:
+		list.clear();
+		emit(prims);
+
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t f = 0; f < frames; ++f) {
+			list.clear();
+			emit(prims);
+			checksum += list.vertices.size();
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+		double count = double(frames) * prims;
+		std::cout << "  " << name << ": " << (count / seconds * 1e-6) << " M/s (" << (seconds * 1e9 / count) << " ns each)";
+		if (!list.vertices.empty()) {
+			//(lists of only quads use DrawListRenderer's fixed quad index buffer, so upload no indices)
+			size_t indexed = list.vertices.size() * sizeof(DrawList::Vertex) + (list.only_quads ? 0 : list.indices.size() * sizeof(uint16_t));
+			if (list.textured) indexed += list.tex_coords.size() * sizeof(glm::vec2);
+			size_t unindexed = list.indices.size() * sizeof(OldVertex);
+			std::cout << "; " << (indexed / double(prims)) << " bytes each uploaded vs. " << (unindexed / double(prims)) << " unindexed";
+		}
+		std::cout << std::endl;
+	};
+
+	std::cout << "draw_list_bench: " << frames << " frames of " << prims << " primitives" << std::endl;
+
+	bench("rectangle", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) list.rectangle(centers[i], glm::vec2(0.1f, 0.2f), color);
+	});
+	bench("rectangles (batched)", [&](uint32_t n) {
+		list.rectangles(centers.data(), n, glm::vec2(0.1f, 0.2f), color);
+	});
+	bench("textured rectangle", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) list.textured_rectangle(centers[i], glm::vec2(0.1f, 0.2f), glm::vec2(0.0f), glm::vec2(1.0f), color);
+	});
+	bench("rotated rectangle", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) list.rectangle(centers[i], glm::vec2(0.1f, 0.2f), 0.001f * i, color);
+	});
+	bench("quad", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) {
+			glm::vec2 c = centers[i];
+			list.quad(c, c + glm::vec2(0.1f, 0.0f), c + glm::vec2(0.1f, 0.1f), c + glm::vec2(0.0f, 0.1f), color);
+		}
+	});
+	bench("circle", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) list.circle(centers[i], 0.25f, color);
+	});
+	bench("sector", [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; ++i) list.sector(centers[i], 0.25f, 0.001f * i, 3.14f, color);
+	});
+
+	//for comparison, the old way: a fresh vector every frame, built with emplace_back:
+	bench("rectangle (fresh vector per frame)", [&](uint32_t n) {
+		std::vector< OldVertex > vertices;
+		for (uint32_t i = 0; i < n; ++i) {
+			glm::vec2 const &c = centers[i];
+			glm::vec2 r = glm::vec2(0.1f, 0.2f);
+			vertices.emplace_back(glm::vec3(c.x-r.x, c.y-r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+			vertices.emplace_back(glm::vec3(c.x+r.x, c.y-r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+			vertices.emplace_back(glm::vec3(c.x+r.x, c.y+r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+			vertices.emplace_back(glm::vec3(c.x-r.x, c.y-r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+			vertices.emplace_back(glm::vec3(c.x+r.x, c.y+r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+			vertices.emplace_back(glm::vec3(c.x-r.x, c.y+r.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+		}
+		checksum += vertices.size();
+	});
+
+	std::cout << "  (checksum " << checksum << ")" << std::endl;
+
+	return 0;
+}
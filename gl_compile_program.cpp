@@ -1,16 +1,33 @@
 #include "gl_compile_program.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
 
-static GLuint gl_compile_shader(GLenum type, std::string const &source) {
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+static GLuint gl_submit_shader(GLenum type, std::string const &source) {
 	GLuint shader = glCreateShader(type);
 	GLchar const *str = source.c_str();
 	GLint length = GLint(source.size());
 	glShaderSource(shader, 1, &str, &length);
 	glCompileShader(shader);
+	//(status is checked later, so the compile can run in the background)
+	return shader;
+}
+
+static void gl_check_shader(GLuint shader) {
 	GLint compile_status = GL_FALSE;
 	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
 	if (compile_status != GL_TRUE) {
@@ -21,30 +38,11 @@ static GLuint gl_compile_shader(GLenum type, std::string const &source) {
 		GLsizei length = 0;
 		glGetShaderInfoLog(shader, GLint(info_log.size()), &length, &info_log[0]);
 		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
-		glDeleteShader(shader);
 		throw std::runtime_error("Failed to compile shader.");
 	}
-	return shader;
 }
 
-GLuint gl_compile_program(
-	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source
-	) {
-
-	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = gl_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-
-	GLuint program = glCreateProgram();
-	glAttachShader(program, vertex_shader);
-	glAttachShader(program, fragment_shader);
-
-	//shaders are reference counted so this makes sure they are freed after program is deleted:
-	glDeleteShader(vertex_shader);
-	glDeleteShader(fragment_shader);
-
-	//link the shader program and throw errors if linking fails:
-	glLinkProgram(program);
+static void gl_check_program(GLuint program) {
 	GLint link_status = GL_FALSE;
 	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
 	if (link_status != GL_TRUE) {
@@ -57,6 +55,279 @@ GLuint gl_compile_program(
 		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
 		throw std::runtime_error("failed to link program");
 	}
+}
+
+GLuint gl_compile_program(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source
+	) {
+
+	GLProgramBatch batch;
+	GLuint program = batch.add(vertex_shader_source, fragment_shader_source);
+	batch.finish();
+	return program;
+}
+
+//----- program binary cache -----
+
+std::string GLProgramBatch::cache_directory;
+
+namespace {
+	//cache file layout: Header, then 'length' bytes of binary:
+	struct Header {
+		char magic[4];
+		uint32_t format;
+		uint64_t key;
+		uint32_t length;
+		uint32_t padding;
+	};
+	static_assert(sizeof(Header) == 24, "program cache header should be packed");
+	constexpr char Magic[4] = {'p', 'g', 'b', '!'};
+
+	//binary formats the driver will accept:
+	std::vector< GLint > const &binary_formats() {
+		static std::vector< GLint > formats;
+		static bool asked = false;
+		if (!asked) {
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+			formats.resize(std::max(count, 0));
+			if (!formats.empty()) glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+			asked = true;
+		}
+		return formats;
+	}
+
+	bool caching() {
+		if (GLProgramBatch::cache_directory.empty() || !gl_caps.ARB_get_program_binary) return false;
+		//(a driver may support the extension but offer no binary formats)
+		return !binary_formats().empty();
+	}
+
+	//FNV-1a over the driver's strings and the sources (binaries are only good for the driver that made them):
+	uint64_t program_key(std::string const &vertex_shader_source, std::string const &fragment_shader_source) {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		auto add = [&hash](char const *str, size_t length) {
+			for (size_t i = 0; i < length; ++i) {
+				hash = (hash ^ uint8_t(str[i])) * 0x100000001b3ULL;
+			}
+			hash = (hash ^ 0xff) * 0x100000001b3ULL; //(separator)
+		};
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			char const *str = reinterpret_cast< char const * >(glGetString(name));
+			if (str) add(str, std::strlen(str));
+		}
+		add(vertex_shader_source.data(), vertex_shader_source.size());
+		add(fragment_shader_source.data(), fragment_shader_source.size());
+		return hash;
+	}
+
+	std::string cache_filename(uint64_t key) {
+		std::ostringstream name;
+		name << GLProgramBatch::cache_directory << '/' << std::hex << std::setw(16) << std::setfill('0') << key << ".glbin";
+		return name.str();
+	}
+
+	bool read_cached(uint64_t key, GLenum *format, std::vector< char > *binary) {
+		std::ifstream file(cache_filename(key), std::ios::binary);
+		Header header;
+		if (!file.read(reinterpret_cast< char * >(&header), sizeof(header))) return false;
+		if (std::memcmp(header.magic, Magic, 4) != 0 || header.key != key) return false;
+		//(passing glProgramBinary a format the driver no longer offers -- e.g., after an update -- is a GL error, not just a failed link)
+		auto const &formats = binary_formats();
+		if (std::find(formats.begin(), formats.end(), GLint(header.format)) == formats.end()) return false;
+		//(a truncated or corrupt entry is just a miss -- its length mustn't be trusted before checking it against the file)
+		std::streamoff start = file.tellg();
+		file.seekg(0, std::ios::end);
+		std::streamoff remaining = file.tellg() - start;
+		if (header.length == 0 || start < 0 || std::streamoff(header.length) != remaining) return false;
+		file.seekg(start);
+		binary->resize(header.length);
+		if (!file.read(binary->data(), binary->size())) return false;
+		*format = header.format;
+		return true;
+	}
+
+	bool write_cached(uint64_t key, GLuint program) {
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return false;
+		std::vector< char > binary(length);
+		GLenum format = 0;
+		GLsizei got = 0;
+		glGetProgramBinary(program, length, &got, &format, binary.data());
+		if (got <= 0) return false;
+
+		#ifdef _WIN32
+		_mkdir(GLProgramBatch::cache_directory.c_str());
+		#else
+		mkdir(GLProgramBatch::cache_directory.c_str(), 0755);
+		#endif
+
+		Header header;
+		std::memcpy(header.magic, Magic, 4);
+		header.format = format;
+		header.key = key;
+		header.length = uint32_t(got);
+		header.padding = 0;
+
+		//write to a temporary file and rename it into place, so a partial binary is never seen:
+		std::string filename = cache_filename(key);
+		std::string temporary = filename + ".tmp";
+		FILE *file = std::fopen(temporary.c_str(), "wb");
+		if (!file) return false;
+		bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+		       && std::fwrite(binary.data(), 1, size_t(got), file) == size_t(got);
+		ok = (std::fclose(file) == 0) && ok;
+		#ifdef _WIN32
+		if (ok) std::remove(filename.c_str()); //(rename won't replace a file on Windows)
+		#endif
+		ok = ok && std::rename(temporary.c_str(), filename.c_str()) == 0;
+		if (!ok) std::remove(temporary.c_str());
+		return ok;
+	}
+}
+
+//----- GLProgramBatch -----
+
+GLProgramBatch::GLProgramBatch() {
+	static bool asked_for_threads = false;
+	if (gl_caps.KHR_parallel_shader_compile && !asked_for_threads) {
+		//let the driver use as many compiler threads as it likes:
+		glMaxShaderCompilerThreadsKHR(0xffffffff);
+		asked_for_threads = true;
+	}
+}
+
+GLProgramBatch::~GLProgramBatch() {
+	for (auto &p : pending) {
+		glDeleteShader(p.vertex_shader);
+		glDeleteShader(p.fragment_shader);
+		glDeleteProgram(p.program);
+	}
+	pending.clear();
+}
 
+GLuint GLProgramBatch::add(std::string const &vertex_shader_source, std::string const &fragment_shader_source, std::function< void(GLuint) > const &linked) {
+	auto before = std::chrono::high_resolution_clock::now();
+
+	Pending p;
+	p.program = glCreateProgram();
+	p.linked = linked;
+	p.vertex_shader_source = vertex_shader_source;
+	p.fragment_shader_source = fragment_shader_source;
+
+	//a cached binary (if there is one) is loaded instead of compiling; finish() checks whether the driver took it:
+	if (caching()) {
+		p.key = program_key(vertex_shader_source, fragment_shader_source);
+		GLenum format = 0;
+		std::vector< char > binary;
+		if (read_cached(p.key, &format, &binary)) {
+			glProgramBinary(p.program, format, binary.data(), GLsizei(binary.size()));
+			p.from_cache = true;
+		}
+	}
+	if (!p.from_cache) submit_sources(p);
+
+	GLuint program = p.program;
+	pending.emplace_back(std::move(p));
+	programs += 1;
+
+	submit_seconds += std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
 	return program;
 }
+
+void GLProgramBatch::submit_sources(Pending &p) {
+	p.vertex_shader = gl_submit_shader(GL_VERTEX_SHADER, p.vertex_shader_source);
+	p.fragment_shader = gl_submit_shader(GL_FRAGMENT_SHADER, p.fragment_shader_source);
+
+	glAttachShader(p.program, p.vertex_shader);
+	glAttachShader(p.program, p.fragment_shader);
+	if (caching()) {
+		//(must be set before linking for glGetProgramBinary to work afterward)
+		glProgramParameteri(p.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	//(linking is also just submitted; if a shader failed to compile, the link fails, and finish() reports why)
+	glLinkProgram(p.program);
+}
+
+void GLProgramBatch::then(std::function< void() > const &done_) {
+	done.emplace_back(done_);
+}
+
+bool GLProgramBatch::ready() const {
+	if (!gl_caps.KHR_parallel_shader_compile) return true;
+	for (auto const &p : pending) {
+		GLint complete = GL_FALSE;
+		glGetProgramiv(p.program, GL_COMPLETION_STATUS_KHR, &complete);
+		if (complete != GL_TRUE) return false;
+	}
+	return true;
+}
+
+void GLProgramBatch::finish() {
+	auto before = std::chrono::high_resolution_clock::now();
+
+	//check (waiting, if need be) in submission order -- later programs keep compiling meanwhile:
+	while (!pending.empty()) {
+		Pending p = std::move(pending.front());
+		pending.erase(pending.begin());
+
+		GLint link_status = GL_FALSE;
+		glGetProgramiv(p.program, GL_LINK_STATUS, &link_status);
+		if (p.from_cache) {
+			if (link_status == GL_TRUE) {
+				cache_hits += 1;
+			} else {
+				//the driver didn't take the cached binary (e.g., it changed in a way its strings don't show), so compile after all:
+				cache_rejected += 1;
+				p.from_cache = false;
+				submit_sources(p);
+				glGetProgramiv(p.program, GL_LINK_STATUS, &link_status);
+			}
+		}
+		try {
+			if (link_status != GL_TRUE) {
+				//a failed compile is the more useful message:
+				gl_check_shader(p.vertex_shader);
+				gl_check_shader(p.fragment_shader);
+				gl_check_program(p.program);
+			}
+		} catch (...) {
+			glDeleteShader(p.vertex_shader);
+			glDeleteShader(p.fragment_shader);
+			glDeleteProgram(p.program);
+			throw;
+		}
+
+		//shaders are reference counted so this makes sure they are freed after program is deleted:
+		glDeleteShader(p.vertex_shader);
+		glDeleteShader(p.fragment_shader);
+
+		if (!p.from_cache && caching()) {
+			if (write_cached(p.key, p.program)) cache_writes += 1;
+		}
+
+		if (p.linked) p.linked(p.program);
+	}
+
+	std::vector< std::function< void() > > to_run;
+	to_run.swap(done);
+	for (auto const &fn : to_run) {
+		fn();
+	}
+
+	wait_seconds += std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+}
+
+void GLProgramBatch::report(std::ostream &out) const {
+	out << "Compiled " << programs << " shader program" << (programs == 1 ? "" : "s")
+		<< " (" << submit_seconds * 1e3 << " ms submitting, " << wait_seconds * 1e3 << " ms waiting"
+		<< (gl_caps.KHR_parallel_shader_compile ? ", in parallel" : "") << ")";
+	if (caching()) {
+		out << "; " << cache_hits << " from binaries cached in '" << cache_directory << "'";
+		if (cache_rejected) out << " (" << cache_rejected << " rejected by the driver)";
+		if (cache_writes) out << ", " << cache_writes << " newly cached";
+	}
+	out << "." << std::endl;
+}
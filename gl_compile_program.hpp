@@ -2,10 +2,75 @@
 
 #include "GL.hpp"
 
+#include <functional>
+#include <iosfwd>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 //compiles+links an OpenGL shader program from source.
 // throws on compilation error.
+// (waits for the driver to finish; to compile several programs at once, use GLProgramBatch)
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source);
+
+//compiles+links many programs at once:
+// add() submits a program's shaders and link without asking whether they worked, so the driver
+// can keep going (on its own threads, with KHR_parallel_shader_compile) while the caller
+// submits more programs or does other startup work; finish() then checks every program.
+//
+// With ARB_get_program_binary, linked programs are also saved to 'cache_directory', keyed by a hash
+// of their sources and the driver's vendor/renderer/version strings; later launches load the binary
+// instead of compiling, and fall back to compiling if the driver rejects it.
+struct GLProgramBatch {
+	GLProgramBatch();
+	~GLProgramBatch(); //(deletes any programs that were never finished)
+
+	GLProgramBatch(GLProgramBatch const &) = delete;
+	GLProgramBatch &operator=(GLProgramBatch const &) = delete;
+
+	//start compiling and linking a program; the returned name can't be used until finish().
+	// 'linked' is called (with the program) during finish(), once it has linked -- e.g., to look up locations:
+	GLuint add(std::string const &vertex_shader_source, std::string const &fragment_shader_source,
+		std::function< void(GLuint) > const &linked = nullptr);
+
+	//call 'done' during finish(), after every program's 'linked' -- e.g., to set up vertex arrays:
+	void then(std::function< void() > const &done);
+
+	//true if finish() wouldn't have to wait (always true without KHR_parallel_shader_compile,
+	// where there is no way to ask without waiting):
+	bool ready() const;
+
+	//wait for every program added so far, check it, and run the callbacks.
+	//NOTE: throws on compile or link error
+	void finish();
+
+	//where program binaries are cached (empty to not cache):
+	static std::string cache_directory;
+
+	//----- statistics -----
+	uint32_t programs = 0; //added (over the batch's lifetime)
+	uint32_t cache_hits = 0; //programs loaded from cached binaries
+	uint32_t cache_rejected = 0; //cached binaries the driver refused (so were compiled after all)
+	uint32_t cache_writes = 0; //binaries saved
+	double submit_seconds = 0.0; //spent in add()
+	double wait_seconds = 0.0; //spent in finish()
+
+	void report(std::ostream &out) const;
+
+private:
+	struct Pending {
+		GLuint program = 0;
+		GLuint vertex_shader = 0;
+		GLuint fragment_shader = 0;
+		std::function< void(GLuint) > linked;
+		//for the binary cache:
+		std::string vertex_shader_source, fragment_shader_source;
+		uint64_t key = 0;
+		bool from_cache = false;
+	};
+	void submit_sources(Pending &p);
+	std::vector< Pending > pending;
+	std::vector< std::function< void() > > done;
+};
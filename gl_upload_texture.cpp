@@ -0,0 +1,28 @@
+#include "gl_upload_texture.hpp"
+
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+
+GLuint gl_upload_texture(TextureCache::Image const &image, GLenum wrap) {
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	gl_state.bind_texture(0, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (uint32_t l = 0; l < image.levels.size(); ++l) {
+		GLsizei width = GLsizei(std::max(image.size.x >> l, 1U));
+		GLsizei height = GLsizei(std::max(image.size.y >> l, 1U));
+		glTexImage2D(GL_TEXTURE_2D, l, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.levels[l]);
+	}
+	bool mipmapped = image.levels.size() > 1;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(image.levels.size()) - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	gl_state.bind_texture(0, 0);
+
+	GL_ERRORS();
+	return texture;
+}
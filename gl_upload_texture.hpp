@@ -0,0 +1,8 @@
+#pragma once
+
+#include "GL.hpp"
+#include "TextureCache.hpp"
+
+//uploads an image (every level it has) to a new texture, straight from wherever
+// it lives (e.g. a mapped cache entry); uses trilinear filtering if it has mip levels.
+GLuint gl_upload_texture(TextureCache::Image const &image, GLenum wrap = GL_CLAMP_TO_EDGE);
@@ -1,10 +1,20 @@
 #include "load_save_png.hpp"
+#include "MappedFile.hpp"
 
 #include <png.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
 #define LOG_ERROR( X ) std::cerr << X << std::endl
@@ -12,23 +22,49 @@
 using std::vector;
 
 bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin);
-void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
+bool save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin, PngSaveOptions const &options);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
+	assert(data);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
+	//decode straight from the mapped file:
+	std::unique_ptr< MappedFile > file;
+	try {
+		file.reset(new MappedFile(filename));
+	} catch (std::runtime_error &) {
 		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
 	}
-	if (!load_png(file, &size->x, &size->y, data, origin)) {
+	try {
+		glm::uvec2 header_size = png_size(file->data, file->size);
+		data->resize(size_t(header_size.x) * header_size.y);
+		*size = load_png(file->data, file->size, data->data(), data->size(), origin);
+	} catch (std::runtime_error &) {
+		data->clear();
 		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
 	}
 }
 
-void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
+void load_png(std::istream &from, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
+	assert(size);
+	if (!load_png(from, &size->x, &size->y, data, origin)) {
+		throw std::runtime_error("Failed to read PNG image from stream.");
+	}
+}
+
+bool save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, PngSaveOptions const &options) {
 	std::ofstream file(filename.c_str(), std::ios::binary);
-	save_png(file, size.x, size.y, data, origin);
+	if (!file) {
+		LOG_ERROR("Failed to open '" << filename << "' for writing.");
+		return false;
+	}
+	if (!save_png(file, size.x, size.y, data, origin, options)) return false;
+	file.close();
+	if (!file) {
+		LOG_ERROR("Error writing png '" << filename << "'.");
+		return false;
+	}
+	return true;
 }
 
 
@@ -40,36 +76,74 @@ static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t lengt
 	}
 }
 
-static void user_write_data(png_structp png_ptr, png_bytep data, png_size_t length) {
-	std::ostream *to = reinterpret_cast< std::ostream * >(png_get_io_ptr(png_ptr));
-	assert(to);
-	if (!to->write(reinterpret_cast< char * >(data), length)) {
-		png_error(png_ptr, "Error writing.");
-	}
-}
+//in-memory PNG data not yet read by libpng:
+struct MemoryReader {
+	uint8_t const *at;
+	size_t remaining;
+};
 
-static void user_flush_data(png_structp png_ptr) {
-	std::ostream *to = reinterpret_cast< std::ostream * >(png_get_io_ptr(png_ptr));
-	assert(to);
-	if (!to->flush()) {
-		png_error(png_ptr, "Error flushing.");
+static void memory_read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
+	MemoryReader *from = reinterpret_cast< MemoryReader * >(png_get_io_ptr(png_ptr));
+	assert(from);
+	if (length > from->remaining) {
+		png_error(png_ptr, "Error reading (PNG data ends early).");
 	}
+	std::memcpy(data, from->at, length);
+	from->at += length;
+	from->remaining -= length;
 }
 
+//decode a PNG read with 'read_fn' into the w*h pixels returned by 'target' (which may return nullptr to refuse the image):
+static bool read_png(png_rw_ptr read_fn, void *io, std::function< glm::u8vec4 *(unsigned int w, unsigned int h) > const &target,
+	OriginLocation origin, unsigned int *width, unsigned int *height);
 
 bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(data);
+	data->clear();
+	bool ok = read_png(user_read_data, &from, [data](unsigned int w, unsigned int h) {
+		data->resize(size_t(w) * h);
+		return data->data();
+	}, origin, width, height);
+	if (!ok) data->clear();
+	return ok;
+}
+
+glm::uvec2 png_size(void const *data, size_t bytes) {
+	uint8_t const *at = reinterpret_cast< uint8_t const * >(data);
+	//signature, then the IHDR chunk (length, "IHDR", width, height, ...):
+	if (bytes < 8 + 8 + 8 || png_sig_cmp(at, 0, 8) != 0 || std::memcmp(at + 12, "IHDR", 4) != 0) {
+		throw std::runtime_error("Not a PNG image.");
+	}
+	auto u32 = [](uint8_t const *p) {
+		return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+	};
+	return glm::uvec2(u32(at + 16), u32(at + 20));
+}
+
+glm::uvec2 load_png(void const *data, size_t bytes, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin) {
+	MemoryReader reader;
+	reader.at = reinterpret_cast< uint8_t const * >(data);
+	reader.remaining = bytes;
+	glm::uvec2 size;
+	bool ok = read_png(memory_read_data, &reader, [pixels, capacity](unsigned int w, unsigned int h) {
+		return (size_t(w) * h <= capacity ? pixels : nullptr);
+	}, origin, &size.x, &size.y);
+	if (!ok) {
+		throw std::runtime_error("Failed to read PNG image from memory.");
+	}
+	return size;
+}
+
+static bool read_png(png_rw_ptr read_fn, void *io, std::function< glm::u8vec4 *(unsigned int w, unsigned int h) > const &target,
+	OriginLocation origin, unsigned int *width, unsigned int *height) {
 	uint32_t local_width, local_height;
 	if (width == nullptr) width = &local_width;
 	if (height == nullptr) height = &local_height;
 	*width = *height = 0;
-	data->clear();
 	//..... load file ......
 	//Load a png file, as per the libpng docs:
 	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
 
-	png_set_read_fn(png, &from, user_read_data);
-
 	if (!png) {
 		LOG_ERROR("  cannot alloc read struct.");
 		return false;
@@ -80,12 +154,13 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 		png_destroy_read_struct(&png, (png_infopp)NULL, (png_infopp)NULL);
 		return false;
 	}
+	png_set_read_fn(png, io, read_fn);
+
 	png_bytep *row_pointers = NULL;
 	if (setjmp(png_jmpbuf(png))) {
 		LOG_ERROR("  png interal error.");
 		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
 		if (row_pointers != NULL) delete[] row_pointers;
-		data->clear();
 		return false;
 	}
 	//not needed with custom read/write functions: png_init_io(png, NULL);
@@ -109,13 +184,16 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 	//Make sure it's the format we think it is...
 	assert(rowbytes == w*sizeof(uint32_t));
 
-	data->resize(w*h);
+	glm::u8vec4 *pixels = target(w, h);
+	if (!pixels) {
+		png_error(png, "Not enough room for image.");
+	}
 	row_pointers = new png_bytep[h];
 	for (unsigned int r = 0; r < h; ++r) {
 		if (origin == LowerLeftOrigin) {
-			row_pointers[h-1-r] = (png_bytep)(&(*data)[r*w]);
+			row_pointers[h-1-r] = (png_bytep)(pixels + size_t(r) * w);
 		} else {
-			row_pointers[r] = (png_bytep)(&(*data)[r*w]);
+			row_pointers[r] = (png_bytep)(pixels + size_t(r) * w);
 		}
 	}
 	png_read_image(png, row_pointers);
@@ -128,48 +206,222 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 }
 
 
-void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin) {
-//After the libpng example.c
-	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-	png_set_write_fn(png_ptr, &to, user_write_data, user_flush_data);
-
-	if (png_ptr == NULL) {
-		LOG_ERROR("Can't create write struct.");
+//run 'fn(i)' for i in [0,count) on up to 'threads' threads:
+template< typename F >
+static void parallel_for(uint32_t count, uint32_t threads, F const &fn) {
+	threads = std::min(threads, count);
+	if (threads <= 1) {
+		for (uint32_t i = 0; i < count; ++i) fn(i);
 		return;
 	}
+	std::atomic< uint32_t > next(0);
+	auto work = [&]() {
+		for (uint32_t i = next++; i < count; i = next++) fn(i);
+	};
+	std::vector< std::thread > helpers;
+	for (uint32_t t = 1; t < threads; ++t) helpers.emplace_back(work);
+	work();
+	for (auto &helper : helpers) helper.join();
+}
 
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (info_ptr == NULL) {
-		png_destroy_write_struct(&png_ptr, NULL);
-		LOG_ERROR("Can't craete info pointer");
-		return;
-	}
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+	int p = int(a) + int(b) - int(c);
+	int pa = std::abs(p - int(a));
+	int pb = std::abs(p - int(b));
+	int pc = std::abs(p - int(c));
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
 
-	if (setjmp(png_jmpbuf(png_ptr))) {
-		png_destroy_write_struct(&png_ptr, &info_ptr);
-		LOG_ERROR("Error writing png.");
-		return;
+//filter one row of 'bytes' bytes (4 per pixel) with filter type 'type' (1-4, or 0 for none):
+static void filter_row(uint8_t type, uint8_t const *row, uint8_t const *prev, size_t bytes, uint8_t *out) {
+	uint32_t const bpp = 4;
+	switch (type) {
+		case PngFilterNone:
+			std::memcpy(out, row, bytes);
+			break;
+		case PngFilterSub:
+			for (size_t i = 0; i < bpp; ++i) out[i] = row[i];
+			for (size_t i = bpp; i < bytes; ++i) out[i] = uint8_t(row[i] - row[i-bpp]);
+			break;
+		case PngFilterUp:
+			for (size_t i = 0; i < bytes; ++i) out[i] = uint8_t(row[i] - prev[i]);
+			break;
+		case PngFilterAverage:
+			for (size_t i = 0; i < bpp; ++i) out[i] = uint8_t(row[i] - (prev[i] >> 1));
+			for (size_t i = bpp; i < bytes; ++i) out[i] = uint8_t(row[i] - ((int(row[i-bpp]) + int(prev[i])) >> 1));
+			break;
+		case PngFilterPaeth:
+			for (size_t i = 0; i < bpp; ++i) out[i] = uint8_t(row[i] - prev[i]); //(paeth(0, b, 0) == b)
+			for (size_t i = bpp; i < bytes; ++i) out[i] = uint8_t(row[i] - paeth(row[i-bpp], prev[i], prev[i-bpp]));
+			break;
+		default:
+			assert(0 && "not a filter type");
 	}
+}
 
-	//Not needed with custom read/write functions: png_init_io(png_ptr, fp);
-	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+//sum of absolute values of filtered bytes (as signed), the usual heuristic for picking a filter:
+static uint64_t filter_cost(uint8_t const *out, size_t bytes) {
+	uint64_t cost = 0;
+	for (size_t i = 0; i < bytes; ++i) cost += uint64_t(std::abs(int(int8_t(out[i]))));
+	return cost;
+}
 
-	png_write_info(png_ptr, info_ptr);
-	//png_set_swap_alpha(png_ptr) // might need?
-	vector< png_bytep > row_pointers(height);
-	for (unsigned int i = 0; i < height; ++i) {
-		if (origin == UpperLeftOrigin) {
-			row_pointers[i] = (png_bytep)&(data[i * width]);
-		} else {
-			row_pointers[i] = (png_bytep)&(data[(height - 1 - i) * width]);
+static void put_u32(std::vector< uint8_t > *to, uint32_t val) {
+	to->emplace_back(uint8_t(val >> 24));
+	to->emplace_back(uint8_t(val >> 16));
+	to->emplace_back(uint8_t(val >> 8));
+	to->emplace_back(uint8_t(val));
+}
+
+bool save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin, PngSaveOptions const &options) {
+	size_t const row_bytes = size_t(width) * 4;
+	//rows in file order (top to bottom):
+	auto row = [&](uint32_t r) -> uint8_t const * {
+		uint32_t index = (origin == UpperLeftOrigin ? r : height - 1 - r);
+		return reinterpret_cast< uint8_t const * >(data + size_t(index) * width);
+	};
+	std::vector< uint8_t > zero_row(row_bytes, 0);
+
+	uint32_t threads = options.threads;
+	if (threads == 0) threads = std::max(1U, std::thread::hardware_concurrency());
+	int level = std::max(0, std::min(9, options.level));
+
+	//strips of about 256k of filtered data each (deflate's 32k window makes smaller strips compress worse):
+	uint32_t strip_rows = uint32_t(std::max< size_t >(1, (size_t(256) << 10) / (row_bytes + 1)));
+	uint32_t strips = std::max(1U, (height + strip_rows - 1) / strip_rows);
+
+	//----- filter each strip -----
+	std::vector< std::vector< uint8_t > > filtered(strips);
+	parallel_for(strips, threads, [&](uint32_t s) {
+		uint32_t begin = s * strip_rows;
+		uint32_t end = std::min(height, begin + strip_rows);
+		std::vector< uint8_t > &out = filtered[s];
+		out.resize(size_t(end - begin) * (row_bytes + 1));
+		std::vector< uint8_t > trial;
+		if (options.filter == PngFilterAdaptive) trial.resize(row_bytes);
+		for (uint32_t r = begin; r < end; ++r) {
+			uint8_t const *cur = row(r);
+			uint8_t const *prev = (r == 0 ? zero_row.data() : row(r - 1));
+			uint8_t *dst = &out[size_t(r - begin) * (row_bytes + 1)];
+			uint8_t type = uint8_t(options.filter);
+			if (options.filter == PngFilterAdaptive) {
+				//try every filter, keep the cheapest:
+				uint64_t best = -1ULL;
+				for (uint8_t t = PngFilterNone; t <= PngFilterPaeth; ++t) {
+					filter_row(t, cur, prev, row_bytes, trial.data());
+					uint64_t cost = filter_cost(trial.data(), row_bytes);
+					if (cost < best) {
+						best = cost;
+						type = t;
+						std::memcpy(dst + 1, trial.data(), row_bytes);
+					}
+				}
+			} else {
+				filter_row(type, cur, prev, row_bytes, dst + 1);
+			}
+			dst[0] = type;
 		}
+	});
+
+	//----- deflate each strip -----
+	std::vector< std::vector< uint8_t > > deflated(strips);
+	std::vector< uLong > adlers(strips);
+	std::atomic< bool > failed(false);
+	parallel_for(strips, threads, [&](uint32_t s) {
+		std::vector< uint8_t > const &in = filtered[s];
+		adlers[s] = adler32(adler32(0L, Z_NULL, 0), in.data(), uInt(in.size()));
+
+		z_stream z;
+		std::memset(&z, 0, sizeof(z));
+		//(raw deflate: the zlib header and checksum are written once, around all the strips)
+		if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			failed = true;
+			return;
+		}
+		if (s > 0) {
+			//continue from the previous strip's data, as a single-threaded encoder would:
+			std::vector< uint8_t > const &prev = filtered[s-1];
+			size_t dict = std::min< size_t >(prev.size(), 32768);
+			deflateSetDictionary(&z, prev.data() + prev.size() - dict, uInt(dict));
+		}
+		bool last = (s + 1 == strips);
+		std::vector< uint8_t > &out = deflated[s];
+		out.resize(deflateBound(&z, uLong(in.size())) + 16); //(+ room for the sync flush marker)
+		z.next_in = const_cast< Bytef * >(in.data());
+		z.avail_in = uInt(in.size());
+		z.next_out = out.data();
+		z.avail_out = uInt(out.size());
+		//(non-final strips end in a sync flush, so they stop on a byte boundary without ending the stream)
+		int ret = deflate(&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+		if (ret != (last ? Z_STREAM_END : Z_OK) || z.avail_in != 0) failed = true;
+		out.resize(out.size() - z.avail_out);
+		deflateEnd(&z);
+	});
+	if (failed) {
+		LOG_ERROR("Error compressing png.");
+		return false;
 	}
-	png_write_image(png_ptr, &(row_pointers[0]));
 
-	png_write_end(png_ptr, info_ptr);
+	uLong adler = adlers[0];
+	for (uint32_t s = 1; s < strips; ++s) {
+		adler = adler32_combine(adler, adlers[s], z_off_t(filtered[s].size()));
+	}
+
+	//----- write the file -----
+	auto write_chunk = [&to](char const *type, std::vector< std::vector< uint8_t > const * > const &parts) {
+		size_t length = 0;
+		for (auto part : parts) length += part->size();
+		std::vector< uint8_t > head;
+		put_u32(&head, uint32_t(length));
+		head.insert(head.end(), type, type + 4);
+		uLong crc = crc32(0L, Z_NULL, 0);
+		crc = crc32(crc, head.data() + 4, 4);
+		to.write(reinterpret_cast< char const * >(head.data()), head.size());
+		for (auto part : parts) {
+			crc = crc32(crc, part->data(), uInt(part->size()));
+			to.write(reinterpret_cast< char const * >(part->data()), part->size());
+		}
+		std::vector< uint8_t > tail;
+		put_u32(&tail, uint32_t(crc));
+		to.write(reinterpret_cast< char const * >(tail.data()), tail.size());
+	};
+
+	static uint8_t const signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	to.write(reinterpret_cast< char const * >(signature), 8);
 
-	png_destroy_write_struct(&png_ptr, &info_ptr);
+	std::vector< uint8_t > ihdr;
+	put_u32(&ihdr, width);
+	put_u32(&ihdr, height);
+	ihdr.emplace_back(8); //bit depth
+	ihdr.emplace_back(6); //color type: RGBA
+	ihdr.emplace_back(0); //compression: deflate
+	ihdr.emplace_back(0); //filter method: adaptive
+	ihdr.emplace_back(0); //interlace: none
+	write_chunk("IHDR", { &ihdr });
 
-	return;
+	//zlib header (32k window, deflate, level hint) and checksum:
+	std::vector< uint8_t > zlib_head;
+	uint8_t cmf = 0x78;
+	uint8_t flg = uint8_t((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6);
+	flg = uint8_t(flg + (31 - (cmf * 256 + flg) % 31) % 31);
+	zlib_head.emplace_back(cmf);
+	zlib_head.emplace_back(flg);
+	std::vector< uint8_t > zlib_tail;
+	put_u32(&zlib_tail, uint32_t(adler));
+
+	std::vector< std::vector< uint8_t > const * > idat;
+	idat.emplace_back(&zlib_head);
+	for (auto const &part : deflated) idat.emplace_back(&part);
+	idat.emplace_back(&zlib_tail);
+	write_chunk("IDAT", idat);
+
+	write_chunk("IEND", { });
+
+	if (!to) {
+		LOG_ERROR("Error writing png.");
+		return false;
+	}
+	return true;
 }
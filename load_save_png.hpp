@@ -2,12 +2,19 @@
 
 #include <glm/glm.hpp>
 
+#include <iosfwd>
 #include <string>
 #include <vector>
+#include <stddef.h>
 #include <stdint.h>
 
 /*
  * Load and save PNG files.
+ *
+ * save_png encodes in parallel: the image is split into horizontal strips,
+ *  each strip is filtered and deflated on its own thread (primed with the end
+ *  of the previous strip as its dictionary, and ended with a sync flush), and
+ *  the pieces are stitched into one zlib stream with a combined Adler-32.
  */
 
 enum OriginLocation {
@@ -15,6 +22,36 @@ enum OriginLocation {
 	UpperLeftOrigin,
 };
 
-//NOTE: load_png will throw on error
+//how save_png picks each row's filter (PNG spec, section 9):
+enum PngFilter {
+	PngFilterNone,
+	PngFilterSub,
+	PngFilterUp,
+	PngFilterAverage,
+	PngFilterPaeth,
+	PngFilterAdaptive, //per row, whichever filter has the smallest sum of absolute differences (as libpng does)
+};
+
+struct PngSaveOptions {
+	int level = 6; //zlib compression level, 0 (store) to 9 (smallest)
+	PngFilter filter = PngFilterAdaptive;
+	uint32_t threads = 0; //threads to encode with (0 means one per core)
+};
+
+//NOTE: load_png will throw on error; save_png prints an error and returns false if the image couldn't be written
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
-void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin);
+bool save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, PngSaveOptions const &options = PngSaveOptions());
+
+//----- decoding into caller-provided memory -----
+//(load_png(filename) maps the file and uses these)
+
+//size of the PNG image in 'data', read from its header (throws if it isn't a PNG):
+glm::uvec2 png_size(void const *data, size_t bytes);
+
+//decode the PNG image in 'data' (e.g., a MappedFile) straight into 'pixels' -- an arena, a mapped
+// pixel-unpack buffer, etc. -- which must have room for 'capacity' pixels; returns the image's size.
+//NOTE: throws on error, including if the image doesn't fit
+glm::uvec2 load_png(void const *data, size_t bytes, glm::u8vec4 *pixels, size_t capacity, OriginLocation origin);
+
+//decode a PNG image from a stream (throws on error):
+void load_png(std::istream &from, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin);
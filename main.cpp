@@ -7,8 +7,26 @@
 //GL.hpp will include a non-namespace-polluting set of opengl prototypes:
 #include "GL.hpp"
 
-//for screenshots:
-#include "load_save_png.hpp"
+//for screenshots and capturing gameplay:
+#include "Screenshots.hpp"
+#include "Capture.hpp"
+
+//for recording and replaying input:
+#include "InputLog.hpp"
+
+//for the vertex buffer and draw list renderer shared by all modes:
+#include "VertexStream.hpp"
+#include "DrawListRenderer.hpp"
+
+//for skipping (and counting) redundant state changes:
+#include "GLState.hpp"
+
+//for compiling every shader program at once:
+#include "gl_compile_program.hpp"
+
+//for timing frames:
+#include "Profiler.hpp"
+#include "FrameStats.hpp"
 
 //Includes for libSDL:
 #include <SDL.h>
@@ -19,6 +37,9 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <string>
+#include <cmath>
+#include <random>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,6 +47,104 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//simulation rate -- Mode::update is always called with elapsed = 1 / tick_rate:
+	float tick_rate = 60.0f;
+	//most updates to run per frame when catching up (beyond this, the game slows down instead):
+	uint32_t max_steps = 5;
+	//seed for the game's random number generator (random unless given):
+	uint32_t seed = std::random_device()();
+	//input log to write this session to:
+	std::string record_filename;
+	//input log to play back (as fast as possible) instead of reading input:
+	std::string replay_filename;
+	//when replaying, skip drawing entirely:
+	bool render = true;
+	//file to write per-frame profile times to:
+	std::string profile_csv_filename;
+	//collect frame time statistics (and print them every 'stats_interval' seconds, if non-zero):
+	bool stats = false;
+	float stats_interval = 0.0f;
+	//record every frame to this target (see Capture.hpp), in this format (guessed from the target if not given):
+	std::string capture_target;
+	std::string capture_format;
+	//frame rate to label captured streams with (0 means the display's refresh rate, or the tick rate for replays):
+	// (frames are captured as they are drawn; this doesn't change how often that is)
+	float capture_fps = 0.0f;
+	//directory to cache linked shader program binaries in (empty to always compile):
+	std::string shader_cache = "shader-cache";
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--tick-rate" && argi + 1 < argc) {
+			tick_rate = std::stof(argv[++argi]);
+		} else if (arg == "--max-steps" && argi + 1 < argc) {
+			max_steps = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--seed" && argi + 1 < argc) {
+			seed = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--record" && argi + 1 < argc) {
+			record_filename = argv[++argi];
+		} else if (arg == "--replay" && argi + 1 < argc) {
+			replay_filename = argv[++argi];
+		} else if (arg == "--no-render") {
+			render = false;
+		} else if (arg == "--profile-csv" && argi + 1 < argc) {
+			profile_csv_filename = argv[++argi];
+		} else if (arg == "--stats") {
+			stats = true;
+		} else if (arg == "--stats-interval" && argi + 1 < argc) {
+			stats = true;
+			stats_interval = std::stof(argv[++argi]);
+		} else if (arg == "--capture" && argi + 1 < argc) {
+			capture_target = argv[++argi];
+		} else if (arg == "--capture-format" && argi + 1 < argc) {
+			capture_format = argv[++argi];
+		} else if (arg == "--capture-fps" && argi + 1 < argc) {
+			capture_fps = std::stof(argv[++argi]);
+		} else if (arg == "--shader-cache" && argi + 1 < argc) {
+			shader_cache = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--tick-rate HZ] [--max-steps N] [--seed S]"
+				" [--record FILE.log | --replay FILE.log [--no-render]] [--profile-csv FILE.csv] [--stats] [--stats-interval SECONDS]"
+				" [--capture 'DIR/%05d.png' | FILE.y4m | FILE.rgba | '|COMMAND' [--capture-format png|y4m|raw] [--capture-fps FPS]]"
+				" [--shader-cache DIR]" << std::endl;
+			return 1;
+		}
+	}
+
+	//a replay runs with the settings it was recorded with:
+	std::unique_ptr< InputLogReader > replay;
+	if (replay_filename != "" && record_filename != "") {
+		std::cerr << "--record and --replay can't be used together." << std::endl;
+		return 1;
+	}
+	if (replay_filename != "") {
+		replay.reset(new InputLogReader(replay_filename));
+		seed = replay->header.seed;
+		tick_rate = replay->header.tick_rate;
+		max_steps = replay->header.max_steps;
+	} else if (!render) {
+		std::cerr << "--no-render only makes sense with --replay." << std::endl;
+		return 1;
+	}
+	Capture::Format capture_as = Capture::format_for(capture_target);
+	if (capture_format == "png") capture_as = Capture::Png;
+	else if (capture_format == "y4m") capture_as = Capture::Y4M;
+	else if (capture_format == "raw") capture_as = Capture::Raw;
+	else if (capture_format != "") {
+		std::cerr << "Capture format should be png, y4m, or raw." << std::endl;
+		return 1;
+	}
+	if (capture_target != "" && !render) {
+		std::cerr << "--capture needs rendering (so can't be used with --no-render)." << std::endl;
+		return 1;
+	}
+	if (!(tick_rate > 0.0f) || max_steps == 0) {
+		std::cerr << "Tick rate and max steps must be positive." << std::endl;
+		return 1;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -72,22 +191,87 @@ int main(int argc, char **argv) {
 		return 1;
 	}
 
-	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
+	//Load OpenGL entrypoints (core ones only on windows) and look for optional extensions:
 	init_GL();
+	gl_caps.report(std::cout);
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	if (replay) {
+		//...except when replaying, which should go as fast as possible:
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
 		}
 	}
 
+	//frame time statistics are judged against the display's refresh rate (which also labels live captures):
+	float refresh_rate = 60.0f;
+	{
+		SDL_DisplayMode mode;
+		if (SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0) {
+			refresh_rate = float(mode.refresh_rate);
+		} else if (stats || capture_target != "") {
+			std::cerr << "NOTE: couldn't get display refresh rate; assuming 60 Hz." << std::endl;
+		}
+	}
+	std::unique_ptr< FrameStats > frame_stats;
+	if (stats) {
+		frame_stats.reset(new FrameStats(refresh_rate, 0.1f));
+	}
+	auto stats_report_time = std::chrono::high_resolution_clock::now();
+
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
 
+	//every shader program is submitted first and checked once the rest of startup is done,
+	// so the driver can compile them all at once (and in parallel, with KHR_parallel_shader_compile);
+	// where the driver allows, programs are loaded from binaries saved by an earlier launch instead:
+	GLProgramBatch::cache_directory = shader_cache;
+	GLProgramBatch programs;
+
+	//------------ create shared drawing resources --------------
+	VertexStream::shared = std::make_shared< VertexStream >();
+	DrawListRenderer::shared = std::make_shared< DrawListRenderer >(&programs);
+	Profiler::shared = std::make_shared< Profiler >();
+	if (profile_csv_filename != "") {
+		Profiler::shared->open_csv(profile_csv_filename);
+		std::cout << "Writing frame times to '" << profile_csv_filename << "'." << std::endl;
+	}
+	Profiler &profiler = *Profiler::shared;
+
+	//screenshots are read back and saved in the background:
+	std::unique_ptr< Screenshots > screenshots(new Screenshots());
+	bool screenshot_requested = false;
+
+	//every frame is captured, if requested:
+	// (replays wait for the writers rather than drop frames, since they aren't running in real time anyway)
+	std::unique_ptr< Capture > capture;
+	if (capture_target != "") {
+		//(live frames arrive at about the refresh rate with vsync; a replay is labeled with its tick rate)
+		if (!(capture_fps > 0.0f)) capture_fps = (replay ? tick_rate : refresh_rate);
+		capture.reset(new Capture(capture_target, capture_as, capture_fps, replay != nullptr));
+		std::cout << "Capturing frames to '" << capture_target << "'." << std::endl;
+	}
+
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< BobMode >());
+	Mode::set_current(std::make_shared< BobMode >(seed, &programs));
+
+	//wait for (and check) the shader programs:
+	programs.finish();
+	programs.report(std::cout);
+
+	std::unique_ptr< InputLogWriter > record;
+	if (record_filename != "") {
+		InputLogHeader header;
+		header.seed = seed;
+		header.tick_rate = tick_rate;
+		header.max_steps = max_steps;
+		record.reset(new InputLogWriter(record_filename, header));
+		std::cout << "Recording input to '" << record_filename << "' (seed " << seed << ")." << std::endl;
+	}
+	auto replay_start = std::chrono::high_resolution_clock::now();
 
 	//------------ main loop ------------
 
@@ -106,69 +290,170 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//deliver one event to the current mode (and handle it here if the mode doesn't):
+	auto dispatch = [&](SDL_Event const &evt, glm::uvec2 const &window_size) {
+		if (record) record->event(evt, window_size);
+		if (Mode::current && Mode::current->handle_event(evt, window_size)) {
+			// mode handled it; great
+		} else if (evt.type == SDL_QUIT) {
+			Mode::set_current(nullptr);
+		} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
+			// --- screenshot key --- (taken after the next frame is drawn)
+			screenshot_requested = true;
+		}
+	};
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
+		profiler.begin_frame();
 
 		{ //(1) process any events that are pending
+			Profiler::Scope scope(profiler, Profiler::Events);
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
 				//handle resizing:
 				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
 					on_resize();
 				}
-				//handle input:
-				if (Mode::current && Mode::current->handle_event(evt, window_size)) {
-					// mode handled it; great
-				} else if (evt.type == SDL_QUIT) {
+				//F3 toggles the profiler overlay (not game input, so not passed to the mode or recorded):
+				if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					if (evt.key.repeat == 0) profiler.overlay = !profiler.overlay;
+					continue;
+				}
+				if (replay) {
+					//when replaying, live input is ignored -- except for closing the window:
+					if (evt.type == SDL_QUIT) Mode::set_current(nullptr);
+				} else {
+					//handle input:
+					dispatch(evt, window_size);
+				}
+				if (!Mode::current) break;
+			}
+			if (!Mode::current) break;
+
+			//when replaying, input comes from the log instead:
+			if (replay) {
+				if (!replay->next_frame()) {
 					Mode::set_current(nullptr);
 					break;
-				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
-					// --- screenshot key ---
-					std::string filename = "screenshot.png";
-					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
-					glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-					glReadBuffer(GL_FRONT);
-					int w,h;
-					SDL_GL_GetDrawableSize(window, &w, &h);
-					std::vector< glm::u8vec4 > data(w*h);
-					glReadPixels(0,0,w,h, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-					for (auto &px : data) {
-						px.a = 0xff;
-					}
-					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
 				}
+				for (auto const &e : replay->events) {
+					dispatch(e.evt, e.window_size);
+					if (!Mode::current) break;
+				}
+				if (!Mode::current) break;
 			}
-			if (!Mode::current) break;
 		}
 
-		{ //(2) call the current mode's "update" function to deal with elapsed time:
+		//fraction of a tick left over after updating; used to interpolate drawing:
+		float alpha = 0.0f;
+
+		{ //(2) call the current mode's "update" function on a fixed timestep to deal with elapsed time:
+			Profiler::Scope scope(profiler, Profiler::Update);
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
 			previous_time = current_time;
 
+			//(the first frame has no previous frame to measure against)
+			if (frame_stats && elapsed > 0.0f) {
+				frame_stats->frame(elapsed);
+				if (stats_interval > 0.0f && std::chrono::duration< float >(current_time - stats_report_time).count() >= stats_interval) {
+					frame_stats->report_window(std::cout);
+					stats_report_time = current_time;
+				}
+			}
+
 			//if frames are taking a very long time to process,
 			//lag to avoid spiral of death:
 			elapsed = std::min(0.1f, elapsed);
 
-			Mode::current->update(elapsed);
+			//replays use the recorded frame times (so they run identically, just faster):
+			if (replay) elapsed = replay->elapsed;
+			if (record) record->end_frame(elapsed);
+
+			//time that has passed but not yet been simulated:
+			static float accumulator = 0.0f;
+			accumulator += elapsed;
+
+			float const tick = 1.0f / tick_rate;
+			uint32_t steps = 0;
+			while (accumulator >= tick && steps < max_steps) {
+				Mode::current->update(tick);
+				if (!Mode::current) break;
+				accumulator -= tick;
+				++steps;
+			}
 			if (!Mode::current) break;
+
+			//still behind after max_steps? drop the backlog rather than trying to catch up next frame:
+			if (accumulator >= tick) accumulator = std::fmod(accumulator, tick);
+
+			alpha = accumulator / tick;
 		}
 
-		{ //(3) call the current mode's "draw" function to produce output:
-		
-			Mode::current->draw(drawable_size);
+		if (render) {
+			{ //(3) call the current mode's "draw" function to produce output:
+				Profiler::Scope scope(profiler, Profiler::Draw);
+				screenshots->update();
+				if (capture) capture->update();
+				VertexStream::shared->begin_frame();
+				profiler.begin_gpu(Profiler::Scene);
+				Mode::current->draw(drawable_size, alpha);
+				profiler.end_gpu();
+				//(screenshots and captures don't include the profiler overlay)
+				if (capture) capture->frame(drawable_size);
+				if (screenshot_requested) {
+					screenshots->take(drawable_size);
+					screenshot_requested = false;
+				}
+				profiler.draw_overlay();
+				VertexStream::shared->end_frame();
+				gl_state.end_frame();
+			}
+
+			//Wait until the recently-drawn frame is shown before doing it all again:
+			Profiler::Scope scope(profiler, Profiler::Swap);
+			SDL_GL_SwapWindow(window);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		profiler.end_frame();
+	}
+
+	if (replay) {
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - replay_start).count();
+		std::cout << "Replayed " << replay->frames << " frames from '" << replay_filename << "' in " << seconds << " s"
+			<< " (" << (replay->frames / seconds) << " frames/second" << (render ? "" : ", not rendering") << ")." << std::endl;
 	}
+	if (record) {
+		std::cout << "Recorded " << record->frames << " frames to '" << record_filename << "'." << std::endl;
+	}
+	VertexStream::shared->report(std::cout);
+	DrawListRenderer::shared->report(std::cout, VertexStream::shared->stats.frames);
+	gl_state.report(std::cout);
+	profiler.flush();
+	profiler.report(std::cout);
+	if (frame_stats) frame_stats->report(std::cout);
+	//close log files before tearing down:
+	record.reset();
+	replay.reset();
 
 
 	//------------  teardown ------------
 
+	//(modes have already released their references to the vertex stream's buffer)
+	if (capture) {
+		capture->finish();
+		capture->report(std::cout);
+	}
+	capture.reset();
+	screenshots.reset(); //(waits for screenshots in progress)
+	Profiler::shared.reset();
+	DrawListRenderer::shared.reset();
+	VertexStream::shared.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
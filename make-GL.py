@@ -2,6 +2,7 @@
 
 #create GL.hpp / GL.cpp by parsing everything from glcorearb.h (why not the regsistry xml, hmmmm?) and selecting only things that are core through version 3_3.
 #get glcorearb.h from https://github.com/KhronosGroup/OpenGL-Registry/raw/master/api/GL/glcorearb.h
+#also emits the optional extensions listed below as function pointers (on every platform), looked up at runtime by init_GL(), with a gl_caps table saying which were found.
 
 import re
 
@@ -9,6 +10,35 @@ filtered = []
 lookups = []
 fps = []
 
+#optional extensions:
+# (gl_caps name, extension strings that provide it, core version that includes it (or None),
+#  functions ('a|b' tries 'a' then 'b'), defines (regexes), typedefs)
+extensions = [
+	("ARB_buffer_storage", ["GL_ARB_buffer_storage"], (4,4),
+		["glBufferStorage"],
+		[r"GL_MAP_PERSISTENT_BIT", r"GL_MAP_COHERENT_BIT", r"GL_DYNAMIC_STORAGE_BIT", r"GL_CLIENT_STORAGE_BIT",
+		 r"GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT", r"GL_BUFFER_IMMUTABLE_STORAGE", r"GL_BUFFER_STORAGE_FLAGS"],
+		[]),
+	("ARB_get_program_binary", ["GL_ARB_get_program_binary"], (4,1),
+		["glGetProgramBinary", "glProgramBinary", "glProgramParameteri"],
+		[r"GL_PROGRAM_BINARY_RETRIEVABLE_HINT", r"GL_PROGRAM_BINARY_LENGTH", r"GL_NUM_PROGRAM_BINARY_FORMATS", r"GL_PROGRAM_BINARY_FORMATS"],
+		[]),
+	("KHR_debug", ["GL_KHR_debug"], (4,3),
+		["glDebugMessageControl", "glDebugMessageInsert", "glDebugMessageCallback", "glGetDebugMessageLog",
+		 "glPushDebugGroup", "glPopDebugGroup", "glObjectLabel", "glGetObjectLabel", "glObjectPtrLabel", "glGetObjectPtrLabel"],
+		[r"GL_DEBUG_.*", r"GL_MAX_DEBUG_.*", r"GL_MAX_LABEL_LENGTH", r"GL_CONTEXT_FLAG_DEBUG_BIT",
+		 r"GL_BUFFER", r"GL_SHADER", r"GL_PROGRAM", r"GL_QUERY", r"GL_PROGRAM_PIPELINE", r"GL_SAMPLER"],
+		["GLDEBUGPROC"]),
+	("ARB_multi_draw_indirect", ["GL_ARB_multi_draw_indirect"], (4,3),
+		["glMultiDrawArraysIndirect", "glMultiDrawElementsIndirect"],
+		[r"GL_DRAW_INDIRECT_BUFFER", r"GL_DRAW_INDIRECT_BUFFER_BINDING"],
+		[]),
+	("KHR_parallel_shader_compile", ["GL_KHR_parallel_shader_compile", "GL_ARB_parallel_shader_compile"], None,
+		["glMaxShaderCompilerThreadsKHR|glMaxShaderCompilerThreadsARB"],
+		[r"GL_MAX_SHADER_COMPILER_THREADS_KHR", r"GL_COMPLETION_STATUS_KHR"],
+		[]),
+]
+
 with open('glcorearb.h', 'r') as f:
 	in_version = None
 	in_notice = False
@@ -102,6 +132,61 @@ with open('glcorearb.h', 'r') as f:
 				continue
 			print("ignoring: " + line)
 
+#everything glcorearb.h declares (in any block), for the optional extensions:
+all_defines = {}
+all_protos = {}
+all_typedefs = {}
+with open('glcorearb.h', 'r') as f:
+	for line in f:
+		line = line.strip()
+		m = re.match(r"^#define (GL_[^\s]+)\s+(0x[0-9A-Fa-f]+)$", line)
+		if m != None and m.group(1) not in all_defines:
+			all_defines[m.group(1)] = line
+		m = re.match(r"GLAPI(.*)APIENTRY ([^\s]+) (.*)$", line)
+		if m != None and m.group(2) not in all_protos:
+			all_protos[m.group(2)] = (m.group(1), m.group(3))
+		m = re.match(r"^typedef.*\(APIENTRY\s+\*([^\s)]+)\)", line)
+		if m != None:
+			all_typedefs[m.group(1)] = line
+
+emitted_defines = set()
+for line in filtered:
+	m = re.match(r"^#define ([^\s]+)", line)
+	if m != None:
+		emitted_defines.add(m.group(1))
+
+ext_filtered = []
+ext_fps = []
+ext_lookups = []
+for (name, strings, core, funcs, defines, typedefs) in extensions:
+	ext_filtered.append("\n// from " + " / ".join(strings) + ("" if core == None else " (core in " + str(core[0]) + "." + str(core[1]) + ")") + ":")
+	for td in typedefs:
+		ext_filtered.append(all_typedefs[td])
+	for pattern in defines:
+		matched = False
+		for (define, line) in all_defines.items():
+			#(skip vendor-suffixed aliases, like GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB, unless asked for by name)
+			if re.fullmatch(pattern, define) and (define == pattern or not re.search(r"_(ARB|KHR|EXT|AMD|NV|INTEL)$", define)):
+				matched = True
+				if define not in emitted_defines:
+					emitted_defines.add(define)
+					ext_filtered.append(line)
+		assert matched, "no defines match " + pattern
+	conditions = []
+	if core != None:
+		conditions.append("core(" + str(core[0]) + ", " + str(core[1]) + ")")
+	conditions += ["has(\"" + e + "\")" for e in strings]
+	check = "\tgl_caps." + name + " = allowed(\"" + name + "\")\n\t\t&& (" + " || ".join(conditions) + ")"
+	for fn in funcs:
+		names = fn.split("|")
+		(rt, ag) = all_protos[names[0]]
+		ext_filtered.append("GLAPI" + rt + "(APIENTRY *ext_" + names[0] + ") " + ag)
+		ext_filtered.append("#define " + names[0] + " ext_" + names[0])
+		ext_fps.append(rt.strip() + " (APIENTRY *ext_" + names[0] + ") " + ag[:-1] + " = nullptr;")
+		check += "\n\t\t&& (" + " || ".join(["LOOKUP(" + names[0] + ", \"" + n + "\")" for n in names]) + ")"
+	ext_lookups.append("\n\t//" + name + ":\n" + check + ";")
+	ext_lookups.append("\tif (!gl_caps." + name + ") {\n" + "".join(["\t\text_" + fn.split("|")[0] + " = nullptr;\n" for fn in funcs]) + "\t}")
+
 
 
 with open("GL.hpp", "w") as f:
@@ -120,10 +205,18 @@ with open("GL.hpp", "w") as f:
  *
  * On MacOS, all are prototypes.
  *
+ * Optional extensions (see the end of this file) are function pointers on
+ *  every platform, looked up by init_GL() only if the context has the
+ *  extension; check gl_caps before using them, and fall back if absent.
+ *  (Setting GL_DISABLE_EXTENSIONS to, e.g., "KHR_debug,ARB_buffer_storage"
+ *  pretends those are missing, to test the fallbacks.)
+ *
  * This file has been automatically generated from glcorearb.h by make-GL.py
  *
  */
 
+#include <iosfwd>
+
 void init_GL(); //will throw on failure.
 
 extern "C" {
@@ -151,15 +244,32 @@ typedef signed   long  int     khronos_ssize_t;
 	print("\n".join(filtered), file=f)
 
 	print("""
-}""", file=f)
+// ----- optional extensions (only valid if gl_caps says so) -----""", file=f)
+	print("\n".join(ext_filtered), file=f)
+
+	print("""
+}
+
+//which optional extensions init_GL() found:
+struct GLCaps {
+	int major = 0, minor = 0; //context version""", file=f)
+	for (name, strings, core, funcs, defines, typedefs) in extensions:
+		print("\tbool " + name + " = false;", file=f)
+	print("""
+	void report(std::ostream &out) const;
+};
+extern GLCaps gl_caps;""", file=f)
 
 
 with open("GL.cpp", "w") as f:
 	print("""#include "GL.hpp"
 
 #include <SDL.h>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <unordered_set>
 
 #ifdef _WIN32
 	#define DO(fn) \\
@@ -171,9 +281,57 @@ with open("GL.cpp", "w") as f:
 	#define DO(fn)
 #endif
 
+static void init_GL_extensions();
+
 void init_GL() {""", file=f)
 	print("\t" + "\n\t".join(lookups),file=f)
-	print("""}
+	print("""
+	init_GL_extensions();
+}
 #ifdef _WIN32""", file=f)
 	print("\t" + "\n\t".join(fps),file=f)
-	print("""#endif""", file=f)
+	print("""#endif
+
+//----- optional extensions -----
+
+GLCaps gl_caps;
+""", file=f)
+	print("\n".join(ext_fps), file=f)
+	print("""
+#define LOOKUP(fn, name) \\
+	((ext_ ## fn = (decltype(ext_ ## fn))SDL_GL_GetProcAddress(name)) != nullptr)
+
+static void init_GL_extensions() {
+	gl_caps = GLCaps();
+	glGetIntegerv(GL_MAJOR_VERSION, &gl_caps.major);
+	glGetIntegerv(GL_MINOR_VERSION, &gl_caps.minor);
+	auto core = [](int major, int minor) {
+		return gl_caps.major > major || (gl_caps.major == major && gl_caps.minor >= minor);
+	};
+
+	std::unordered_set< std::string > extensions;
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; ++i) {
+		char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+		if (name) extensions.insert(name);
+	}
+
+	//GL_DISABLE_EXTENSIONS lists gl_caps entries to treat as missing:
+	std::string disabled;
+	if (char const *env = std::getenv("GL_DISABLE_EXTENSIONS")) disabled = std::string(",") + env + ",";
+	auto has = [&extensions](char const *name) {
+		return extensions.count(name) != 0;
+	};
+	auto allowed = [&disabled](char const *cap) {
+		return disabled.find(std::string(",") + cap + ",") == std::string::npos;
+	};""", file=f)
+	print("\n".join(ext_lookups), file=f)
+	print("""}
+
+void GLCaps::report(std::ostream &out) const {
+	out << "OpenGL " << major << "." << minor << ":";""", file=f)
+	for (name, strings, core, funcs, defines, typedefs) in extensions:
+		print("\tout << \" " + name + "\" << (" + name + " ? \" yes\" : \" no\");", file=f)
+	print("""	out << std::endl;
+}""", file=f)
@@ -0,0 +1,204 @@
+//png_bench measures how fast save_png encodes and load_png decodes (no window or OpenGL needed).
+// usage: png_bench [--size W H] [--runs N] [--level L] [--threads N] [--out FILE.png] [--assets N] [--cache DIR]
+// encodes a synthetic image (gradients, flat areas, and noise -- roughly like a screenshot)
+// with one thread and then with every core (or --threads), and checks that the result decodes to the same pixels;
+// then decodes it through a std::istream (into a fresh vector) and from a MappedFile (into a reused buffer);
+// then loads a set of --assets smaller images (512x512 tiles of it) the way startup would: decoding each one,
+// then through a TextureCache (in --cache DIR) on its first launch, and then on later launches.
+
+#include "load_save_png.hpp"
+#include "MappedFile.hpp"
+#include "TextureCache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main(int argc, char **argv) {
+	glm::uvec2 size = glm::uvec2(1920, 1080);
+	uint32_t runs = 5;
+	PngSaveOptions options;
+	std::string out = "png_bench.png";
+	uint32_t threads = std::thread::hardware_concurrency();
+	uint32_t assets = 48;
+	std::string cache_directory = "png_bench-cache";
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--size" && argi + 2 < argc) {
+			size.x = uint32_t(std::stoul(argv[++argi]));
+			size.y = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--runs" && argi + 1 < argc) {
+			runs = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--level" && argi + 1 < argc) {
+			options.level = std::stoi(argv[++argi]);
+		} else if (arg == "--threads" && argi + 1 < argc) {
+			threads = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--out" && argi + 1 < argc) {
+			out = argv[++argi];
+		} else if (arg == "--assets" && argi + 1 < argc) {
+			assets = uint32_t(std::stoul(argv[++argi]));
+		} else if (arg == "--cache" && argi + 1 < argc) {
+			cache_directory = argv[++argi];
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--size W H] [--runs N] [--level L] [--threads N] [--out FILE.png] [--assets N] [--cache DIR]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector< glm::u8vec4 > image(size.x * size.y);
+	uint32_t noise = 1;
+	for (uint32_t y = 0; y < size.y; ++y) {
+		for (uint32_t x = 0; x < size.x; ++x) {
+			glm::u8vec4 &px = image[y * size.x + x];
+			if ((x / 64 + y / 64) % 3 == 0) {
+				//flat:
+				px = glm::u8vec4(0x22, 0x33, 0x44, 0xff);
+			} else if ((x / 64 + y / 64) % 3 == 1) {
+				//gradient:
+				px = glm::u8vec4(x * 255 / size.x, y * 255 / size.y, 0x80, 0xff);
+			} else {
+				//noise:
+				noise = noise * 1664525U + 1013904223U;
+				px = glm::u8vec4(noise >> 24, noise >> 16, noise >> 8, 0xff);
+			}
+		}
+	}
+
+	std::cout << "png_bench: " << size.x << "x" << size.y << ", level " << options.level << ", " << runs << " runs" << std::endl;
+
+	auto bench = [&](char const *name, PngSaveOptions const &opts) {
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < runs; ++r) {
+			save_png(out, size, image.data(), UpperLeftOrigin, opts);
+		}
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count() / runs;
+		std::ifstream file(out, std::ios::binary | std::ios::ate);
+		size_t bytes = size_t(file.tellg());
+
+		glm::uvec2 check_size;
+		std::vector< glm::u8vec4 > check;
+		load_png(out, &check_size, &check, UpperLeftOrigin);
+		bool same = (check_size == size && check == image);
+
+		std::cout << "  " << name << ": " << (seconds * 1e3) << " ms, " << (bytes / 1024.0) << " KiB"
+			<< (same ? "" : " -- MISMATCH after decoding!") << std::endl;
+		return seconds;
+	};
+
+	PngSaveOptions one = options;
+	one.threads = 1;
+	double single = bench("1 thread", one);
+
+	PngSaveOptions all = options;
+	all.threads = threads;
+	double parallel = bench((std::to_string(threads) + " threads").c_str(), all);
+	std::cout << "  (" << (single / parallel) << "x faster)" << std::endl;
+
+	for (PngFilter filter : { PngFilterNone, PngFilterSub, PngFilterUp, PngFilterPaeth }) {
+		PngSaveOptions f = all;
+		f.filter = filter;
+		bench((std::string("filter ") + std::to_string(int(filter))).c_str(), f);
+	}
+
+	//----- decoding -----
+	save_png(out, size, image.data(), UpperLeftOrigin, all);
+
+	auto decode_bench = [&](char const *name, std::function< void() > const &decode) {
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t r = 0; r < runs; ++r) decode();
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count() / runs;
+		std::cout << "  " << name << ": " << (seconds * 1e3) << " ms" << std::endl;
+		return seconds;
+	};
+
+	std::vector< glm::u8vec4 > decoded;
+	double streamed = decode_bench("decode (stream, new vector)", [&]() {
+		std::ifstream file(out, std::ios::binary);
+		glm::uvec2 decoded_size;
+		std::vector< glm::u8vec4 > fresh;
+		load_png(file, &decoded_size, &fresh, UpperLeftOrigin);
+		decoded.swap(fresh);
+	});
+	bool stream_same = (decoded == image);
+
+	std::vector< glm::u8vec4 > arena(size.x * size.y);
+	double mapped = decode_bench("decode (mapped, into buffer)", [&]() {
+		MappedFile file(out);
+		load_png(file.data, file.size, arena.data(), arena.size(), UpperLeftOrigin);
+	});
+	bool mapped_same = (arena == image);
+
+	std::cout << "  (" << (streamed / mapped) << "x faster" << (stream_same && mapped_same ? "" : " -- MISMATCH after decoding!") << ")" << std::endl;
+
+	//----- startup: decoding every asset vs. the texture cache -----
+	glm::uvec2 tile = glm::min(size, glm::uvec2(512));
+	std::vector< std::string > names;
+	for (uint32_t a = 0; a < assets; ++a) {
+		//each asset is a tile of the image, so they differ:
+		uint32_t tiles_x = size.x / tile.x;
+		uint32_t tiles_y = size.y / tile.y;
+		glm::uvec2 at = tile * glm::uvec2(a % tiles_x, (a / tiles_x) % tiles_y);
+		std::vector< glm::u8vec4 > pixels(tile.x * tile.y);
+		for (uint32_t y = 0; y < tile.y; ++y) {
+			std::copy(&image[(at.y + y) * size.x + at.x], &image[(at.y + y) * size.x + at.x] + tile.x, &pixels[y * tile.x]);
+		}
+		names.emplace_back(out.substr(0, out.rfind('.')) + "-asset-" + std::to_string(a) + ".png");
+		save_png(names.back(), tile, pixels.data(), UpperLeftOrigin, all);
+	}
+	double megabytes = assets * (tile.x * tile.y * 4.0) / (1024.0 * 1024.0);
+	std::cout << "startup: " << assets << " assets of " << tile.x << "x" << tile.y << " (" << megabytes << " MiB decoded)" << std::endl;
+
+	//(sums every pixel, so mapped entries are actually read in)
+	uint32_t checksum = 0;
+	auto touch = [&checksum](glm::u8vec4 const *pixels, size_t count) {
+		for (size_t i = 0; i < count; ++i) checksum += pixels[i].r + pixels[i].g + pixels[i].b + pixels[i].a;
+	};
+
+	auto startup = [&](char const *name, std::function< void(std::string const &) > const &load) {
+		auto before = std::chrono::high_resolution_clock::now();
+		for (auto const &asset : names) load(asset);
+		double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+		std::cout << "  " << name << ": " << (seconds * 1e3) << " ms (" << (megabytes / seconds) << " MiB/s)" << std::endl;
+		return seconds;
+	};
+
+	uint32_t decoded_checksum = 0;
+	double decoding = startup("decode every asset", [&](std::string const &asset) {
+		glm::uvec2 asset_size;
+		std::vector< glm::u8vec4 > pixels;
+		load_png(asset, &asset_size, &pixels, LowerLeftOrigin);
+		touch(pixels.data(), pixels.size());
+	});
+	std::swap(checksum, decoded_checksum);
+
+	for (bool mipmaps : { false, true }) {
+		TextureCache cache(cache_directory);
+		for (auto const &asset : names) std::remove(cache.entry_filename(asset, mipmaps).c_str());
+		std::string with = (mipmaps ? " (with mip levels)" : "");
+
+		startup(("first launch, filling cache" + with).c_str(), [&](std::string const &asset) {
+			TextureCache::Image loaded = cache.load(asset, mipmaps);
+			touch(loaded.levels[0], size_t(loaded.size.x) * loaded.size.y);
+		});
+		checksum = 0;
+		double cached = startup(("later launch, from cache" + with).c_str(), [&](std::string const &asset) {
+			TextureCache::Image loaded = cache.load(asset, mipmaps);
+			touch(loaded.levels[0], size_t(loaded.size.x) * loaded.size.y);
+		});
+		std::cout << "  (" << (decoding / cached) << "x faster than decoding"
+			<< (checksum == decoded_checksum ? "" : " -- MISMATCH with decoded pixels!") << ")" << std::endl;
+		std::cout << "  ";
+		cache.report(std::cout);
+
+		for (auto const &asset : names) std::remove(cache.entry_filename(asset, mipmaps).c_str());
+	}
+	for (auto const &asset : names) std::remove(asset.c_str());
+
+	return 0;
+}